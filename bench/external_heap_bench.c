@@ -0,0 +1,128 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// N random keys inserted and then all extracted, by the external heap under
+// a memory budget a tenth the size of the data, against heap.c holding all
+// of it in memory. The external heap also runs with 8KB blocks under a
+// budget a two hundredth the size of the data, so that its in-memory heap
+// spills about four hundred runs, and merging them dominates. For both, it
+// reports how many times over each element was written to disk.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#include "horror/macro.h"
+
+#define EH_SCOPE HR_SCOPE_STATIC_INLINE
+#define EH_ELEM_TYPE uint64_t
+#define EH_NAME eh
+#define EH_CMP(x, y) ((x) < (y))
+#include "horror/external_heap.c"
+
+#define EH_SCOPE HR_SCOPE_STATIC_INLINE
+#define EH_ELEM_TYPE uint64_t
+#define EH_NAME eh_small
+#define EH_CMP(x, y) ((x) < (y))
+#define EH_BLOCK_BYTES 8192
+#include "horror/external_heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE uint64_t
+#define HP_NAME hp
+#define HP_CMP(x, y) ((x) < (y))
+#include "horror/heap.c"
+
+
+#define N 10000000
+
+
+#define BENCH(fn, name, label, budget)                                      \
+    static void fn(void) {                                                  \
+        HR_CONCAT(name, _t) eh;                                             \
+        uint64_t seed = 42, x;                                              \
+        size_t runs = 0;                                                    \
+        if (!HR_CONCAT(name, _init)(&eh, budget)) {                         \
+            return;                                                         \
+        }                                                                   \
+        double start = bench_now();                                         \
+        for (size_t i = 0; i < N; i++) {                                    \
+            HR_CONCAT(name, _insert)(&eh, bench_rand(&seed));               \
+            if (HR_CONCAT(name, _runs)(&eh) > runs) {                       \
+                runs = HR_CONCAT(name, _runs)(&eh);                         \
+            }                                                               \
+        }                                                                   \
+        bench_report("external_heap.c insert, " label, N,                   \
+                     bench_now() - start);                                  \
+        start = bench_now();                                                \
+        while (HR_CONCAT(name, _extract)(&eh, &x)) {                        \
+            bench_sink += x;                                                \
+        }                                                                   \
+        bench_report("external_heap.c extract, " label, N,                  \
+                     bench_now() - start);                                  \
+        printf("%-48s %10zu runs at most\n", "", runs);                     \
+        printf("%-48s %10.2f writes per element\n", "",                     \
+               (double)HR_CONCAT(name, _written)(&eh) / N);                 \
+        HR_CONCAT(name, _cleanup)(&eh);                                     \
+    }
+
+BENCH(bench_eh, eh, "budget N/10", N * sizeof(uint64_t) / 10)
+BENCH(bench_eh_small, eh_small, "8KB blocks, budget N/200", N * sizeof(uint64_t) / 200)
+
+
+static void bench_hp(void) {
+    hp_t hp;
+    uint64_t seed = 42;
+
+    if (!hp_init(&hp, 16)) {
+        return;
+    }
+
+    double start = bench_now();
+    for (size_t i = 0; i < N; i++) {
+        hp_insert(&hp, bench_rand(&seed));
+    }
+    bench_report("heap.c insert, all in memory", N, bench_now() - start);
+
+    start = bench_now();
+    for (size_t i = 0; i < N; i++) {
+        bench_sink += hp_extract(&hp);
+    }
+    bench_report("heap.c extract, all in memory", N, bench_now() - start);
+
+    hp_cleanup(&hp);
+}
+
+
+int main(void) {
+    bench_eh();
+    bench_eh_small();
+    bench_hp();
+    return 0;
+}
@@ -0,0 +1,150 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// Compares heap arities 2, 4 and 8 on `int` elements and on 32-byte records,
+// for a round of N random inserts followed by N extracts.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#include "horror/macro.h"
+
+typedef struct {
+    uint64_t key;
+    char payload[24];
+} record_t;
+
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_int2
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_ARITY 2
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_int4
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_ARITY 4
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_int8
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_ARITY 8
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE record_t
+#define HP_NAME hp_rec2
+#define HP_CMP(x, y) ((x).key < (y).key)
+#define HP_ARITY 2
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE record_t
+#define HP_NAME hp_rec4
+#define HP_CMP(x, y) ((x).key < (y).key)
+#define HP_ARITY 4
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE record_t
+#define HP_NAME hp_rec8
+#define HP_CMP(x, y) ((x).key < (y).key)
+#define HP_ARITY 8
+#include "horror/heap.c"
+
+
+#define N 1000000
+
+#define NAME_BENCH_(name) HR_CONCAT(bench_, name)
+
+#define BENCH_INT(name)                                                     \
+    static void NAME_BENCH_(name)(void) {                                   \
+        HR_CONCAT(name, _t) hp;                                             \
+        uint64_t seed = 42;                                                 \
+        if (!HR_CONCAT(name, _init)(&hp, 16)) {                             \
+            return;                                                         \
+        }                                                                   \
+        double start = bench_now();                                         \
+        for (size_t i = 0; i < N; i++) {                                    \
+            HR_CONCAT(name, _insert)(&hp, (int)(bench_rand(&seed) >> 33));  \
+        }                                                                   \
+        for (size_t i = 0; i < N; i++) {                                    \
+            bench_sink += HR_CONCAT(name, _extract)(&hp);                   \
+        }                                                                   \
+        bench_report(#name " insert+extract", 2 * N, bench_now() - start);  \
+        HR_CONCAT(name, _cleanup)(&hp);                                     \
+    }
+
+#define BENCH_REC(name)                                                     \
+    static void NAME_BENCH_(name)(void) {                                   \
+        HR_CONCAT(name, _t) hp;                                             \
+        uint64_t seed = 42;                                                 \
+        if (!HR_CONCAT(name, _init)(&hp, 16)) {                             \
+            return;                                                         \
+        }                                                                   \
+        double start = bench_now();                                         \
+        for (size_t i = 0; i < N; i++) {                                    \
+            record_t r = { .key = bench_rand(&seed) };                      \
+            HR_CONCAT(name, _insert)(&hp, r);                               \
+        }                                                                   \
+        for (size_t i = 0; i < N; i++) {                                    \
+            bench_sink += HR_CONCAT(name, _extract)(&hp).key;               \
+        }                                                                   \
+        bench_report(#name " insert+extract", 2 * N, bench_now() - start);  \
+        HR_CONCAT(name, _cleanup)(&hp);                                     \
+    }
+
+BENCH_INT(hp_int2)
+BENCH_INT(hp_int4)
+BENCH_INT(hp_int8)
+BENCH_REC(hp_rec2)
+BENCH_REC(hp_rec4)
+BENCH_REC(hp_rec8)
+
+
+int main(void) {
+    bench_hp_int2();
+    bench_hp_int4();
+    bench_hp_int8();
+    bench_hp_rec2();
+    bench_hp_rec4();
+    bench_hp_rec8();
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// Extraction with the standard sift-down against HP_BOTTOM_UP, on 32-byte
+// records moved with HP_MEMCPY_ELEM. Besides time, counts the comparisons and
+// element copies made during the extracts.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+#include "horror/macro.h"
+
+typedef struct {
+    uint64_t key;
+    char payload[24];
+} record_t;
+
+static uint64_t compares, copies;
+
+#define COUNTED_CMP(x, y) (compares++, (x).key < (y).key)
+#define COUNTED_MEMCPY(dst, src) (copies++, memcpy((dst), (src), sizeof(record_t)))
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE record_t
+#define HP_NAME hp_std
+#define HP_CMP(x, y) COUNTED_CMP(x, y)
+#define HP_MEMCPY_ELEM(dst, src) COUNTED_MEMCPY(dst, src)
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE record_t
+#define HP_NAME hp_bu
+#define HP_CMP(x, y) COUNTED_CMP(x, y)
+#define HP_MEMCPY_ELEM(dst, src) COUNTED_MEMCPY(dst, src)
+#define HP_BOTTOM_UP
+#include "horror/heap.c"
+
+
+#define N 1000000
+
+
+#define BENCH(name, label)                                                  \
+    static void HR_CONCAT(bench_, name)(void) {                             \
+        HR_CONCAT(name, _t) hp;                                             \
+        uint64_t seed = 42;                                                 \
+        if (!HR_CONCAT(name, _init)(&hp, N)) {                              \
+            return;                                                         \
+        }                                                                   \
+        for (size_t i = 0; i < N; i++) {                                    \
+            record_t r = { .key = bench_rand(&seed) };                      \
+            HR_CONCAT(name, _insert)(&hp, &r);                              \
+        }                                                                   \
+        compares = copies = 0;                                              \
+        double start = bench_now();                                         \
+        for (size_t i = 0; i < N; i++) {                                    \
+            bench_sink += HR_CONCAT(name, _extract)(&hp).key;               \
+        }                                                                   \
+        bench_report(label, N, bench_now() - start);                        \
+        printf("%-48s %10.2f compares/op %6.2f copies/op\n", "",            \
+               (double)compares / N, (double)copies / N);                   \
+        HR_CONCAT(name, _cleanup)(&hp);                                     \
+    }
+
+BENCH(hp_std, "heap.c extract")
+BENCH(hp_bu, "heap.c HP_BOTTOM_UP extract")
+
+
+int main(void) {
+    bench_hp_std();
+    bench_hp_bu();
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// A scheduler's tick loop on a heap of 1M deadlines: each tick takes every
+// deadline that's due, then schedules as many new ones further out. The due
+// deadlines are taken with a peek-and-extract loop against a single
+// _extract_until, for a few batch sizes.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#include "horror/macro.h"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE uint64_t
+#define HP_NAME hp_u64
+#define HP_CMP(x, y) ((x) < (y))
+#include "horror/heap.c"
+
+
+#define N 1000000
+#define OPS 4000000
+
+
+static uint64_t out[1 << 16];
+
+
+// Deadlines are spread evenly over N ticks' worth of time, so that `batch`
+// of them come due per tick on average.
+static void run(const char* label, size_t batch, bool until) {
+    hp_u64_t hp;
+    uint64_t seed = 42, span = (uint64_t)N / batch, now = 0;
+
+    if (!hp_u64_init(&hp, N)) {
+        return;
+    }
+    for (size_t i = 0; i < N; i++) {
+        hp_u64_insert(&hp, bench_rand(&seed) % span);
+    }
+
+    size_t done = 0;
+    double start = bench_now();
+
+    while (done < OPS) {
+        now += 1;
+        size_t k = 0;
+
+        if (until) {
+            k = hp_u64_extract_until(&hp, now, out, sizeof(out) / sizeof(out[0]));
+        } else {
+            while (*hp_u64_peek(&hp) < now) {
+                out[k++] = hp_u64_extract(&hp);
+            }
+        }
+
+        for (size_t i = 0; i < k; i++) {
+            bench_sink += out[i];
+            hp_u64_insert(&hp, now + bench_rand(&seed) % span);
+        }
+
+        done += k;
+    }
+
+    bench_report(label, done, bench_now() - start);
+    hp_u64_cleanup(&hp);
+}
+
+
+int main(void) {
+    run("peek/extract loop, ~16 due per tick", 16, false);
+    run("heap.c _extract_until, ~16 due per tick", 16, true);
+    run("peek/extract loop, ~256 due per tick", 256, false);
+    run("heap.c _extract_until, ~256 due per tick", 256, true);
+    run("peek/extract loop, ~4096 due per tick", 4096, false);
+    run("heap.c _extract_until, ~4096 due per tick", 4096, true);
+    return 0;
+}
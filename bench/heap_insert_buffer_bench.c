@@ -0,0 +1,93 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// An insert-heavy workload (twenty insertions of random keys per extraction)
+// on a heap of ints, sifting each insertion up against buffering them with
+// HP_INSERT_BUFFER.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#include "horror/macro.h"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE uint32_t
+#define HP_NAME hp_plain
+#define HP_CMP(x, y) ((x) < (y))
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE uint32_t
+#define HP_NAME hp_buffer
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_INSERT_BUFFER 64
+#include "horror/heap.c"
+
+
+#define OPS 4200000
+#define RATIO 20
+
+
+#define BENCH(fn, name, label, n)                                           \
+    static void fn(void) {                                                  \
+        HR_CONCAT(name, _t) hp;                                             \
+        uint64_t seed = 42;                                                 \
+        if (!HR_CONCAT(name, _init)(&hp, n)) {                              \
+            return;                                                         \
+        }                                                                   \
+        for (size_t i = 0; i < n; i++) {                                    \
+            HR_CONCAT(name, _insert)(&hp, (uint32_t)bench_rand(&seed));     \
+        }                                                                   \
+        double start = bench_now();                                         \
+        for (size_t i = 0; i < OPS; i++) {                                  \
+            if (i % (RATIO + 1) == RATIO) {                                 \
+                bench_sink += HR_CONCAT(name, _extract)(&hp);               \
+            } else {                                                        \
+                HR_CONCAT(name, _insert)(&hp, (uint32_t)bench_rand(&seed)); \
+            }                                                               \
+        }                                                                   \
+        bench_report(label, OPS, bench_now() - start);                      \
+        HR_CONCAT(name, _cleanup)(&hp);                                     \
+    }
+
+BENCH(bench_plain_1k, hp_plain, "heap.c 20:1 inserts, plain, n=1K", 1000)
+BENCH(bench_buffer_1k, hp_buffer, "heap.c 20:1 inserts, HP_INSERT_BUFFER=64, n=1K", 1000)
+BENCH(bench_plain_1m, hp_plain, "heap.c 20:1 inserts, plain, n=1M", 1000000)
+BENCH(bench_buffer_1m, hp_buffer, "heap.c 20:1 inserts, HP_INSERT_BUFFER=64, n=1M", 1000000)
+
+
+int main(void) {
+    bench_plain_1k();
+    bench_buffer_1k();
+    bench_plain_1m();
+    bench_buffer_1m();
+    return 0;
+}
@@ -0,0 +1,97 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// Churn (extract the root, reinsert it with a fresh random key) on 64-byte
+// records, with the records themselves in the heap array against HP_KEY_TYPE,
+// where sifting only moves 8-byte keys and 4-byte payload indices.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+#include "horror/macro.h"
+
+typedef struct {
+    uint64_t key;
+    char payload[56];
+} record_t;
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE record_t
+#define HP_NAME hp_std
+#define HP_CMP(x, y) ((x).key < (y).key)
+#define HP_MEMCPY_ELEM(dst, src) memcpy((dst), (src), sizeof(record_t))
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE record_t
+#define HP_NAME hp_key
+#define HP_KEY_TYPE uint64_t
+#define HP_KEY_OF(x) ((x).key)
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_MEMCPY_ELEM(dst, src) memcpy((dst), (src), sizeof(record_t))
+#include "horror/heap.c"
+
+
+#define OPS 2000000
+
+
+#define BENCH(name, label, n)                                               \
+    static void HR_CONCAT(bench_, name)(void) {                             \
+        HR_CONCAT(name, _t) hp;                                             \
+        uint64_t seed = 42;                                                 \
+        if (!HR_CONCAT(name, _init)(&hp, n)) {                              \
+            return;                                                         \
+        }                                                                   \
+        for (size_t i = 0; i < n; i++) {                                    \
+            record_t r = { .key = bench_rand(&seed) >> 1 };                 \
+            HR_CONCAT(name, _insert)(&hp, &r);                              \
+        }                                                                   \
+        double start = bench_now();                                         \
+        for (size_t i = 0; i < OPS; i++) {                                  \
+            record_t r = HR_CONCAT(name, _extract)(&hp);                    \
+            bench_sink += r.payload[0];                                     \
+            r.key = bench_rand(&seed) >> 1;                                 \
+            HR_CONCAT(name, _insert)(&hp, &r);                              \
+        }                                                                   \
+        bench_report(label, OPS, bench_now() - start);                      \
+        HR_CONCAT(name, _cleanup)(&hp);                                     \
+    }
+
+BENCH(hp_std, "heap.c hold, 64-byte records, n=1M", 1000000)
+BENCH(hp_key, "heap.c HP_KEY_TYPE hold, 64-byte records, n=1M", 1000000)
+
+
+int main(void) {
+    bench_hp_std();
+    bench_hp_key();
+    return 0;
+}
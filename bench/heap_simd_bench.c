@@ -0,0 +1,150 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// Extraction from wide heaps of plain numbers, picking the least child with
+// the usual scalar loop against HP_SIMD. N random keys go in untimed, then all
+// N are extracted.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#include "horror/macro.h"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int32_t
+#define HP_NAME hp_i32x8
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_ARITY 8
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int32_t
+#define HP_NAME hp_i32x8_simd
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_ARITY 8
+#define HP_SIMD HR_SIMD_INT32
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int32_t
+#define HP_NAME hp_i32x16
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_ARITY 16
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int32_t
+#define HP_NAME hp_i32x16_simd
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_ARITY 16
+#define HP_SIMD HR_SIMD_INT32
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int64_t
+#define HP_NAME hp_i64x8
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_ARITY 8
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int64_t
+#define HP_NAME hp_i64x8_simd
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_ARITY 8
+#define HP_SIMD HR_SIMD_INT64
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE float
+#define HP_NAME hp_f32x8
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_ARITY 8
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE float
+#define HP_NAME hp_f32x8_simd
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_ARITY 8
+#define HP_SIMD HR_SIMD_FLOAT
+#include "horror/heap.c"
+
+
+#define N 1000000
+
+#define BENCH(name, type)                                                   \
+    static void HR_CONCAT(bench_, name)(void) {                             \
+        HR_CONCAT(name, _t) hp;                                             \
+        uint64_t seed = 42;                                                 \
+        if (!HR_CONCAT(name, _init)(&hp, N)) {                              \
+            return;                                                         \
+        }                                                                   \
+        for (size_t i = 0; i < N; i++) {                                    \
+            type x = (type)(int32_t)(bench_rand(&seed) >> 32);              \
+            HR_CONCAT(name, _insert)(&hp, x);                               \
+        }                                                                   \
+        double start = bench_now();                                         \
+        for (size_t i = 0; i < N; i++) {                                    \
+            type x = HR_CONCAT(name, _extract)(&hp);                        \
+            bench_sink += (uint64_t)(int64_t)x;                             \
+        }                                                                   \
+        bench_report(#name " extract", N, bench_now() - start);             \
+        HR_CONCAT(name, _cleanup)(&hp);                                     \
+    }
+
+BENCH(hp_i32x8, int32_t)
+BENCH(hp_i32x8_simd, int32_t)
+BENCH(hp_i32x16, int32_t)
+BENCH(hp_i32x16_simd, int32_t)
+BENCH(hp_i64x8, int64_t)
+BENCH(hp_i64x8_simd, int64_t)
+BENCH(hp_f32x8, float)
+BENCH(hp_f32x8_simd, float)
+
+
+int main(void) {
+    bench_hp_i32x8();
+    bench_hp_i32x8_simd();
+    bench_hp_i32x16();
+    bench_hp_i32x16_simd();
+    bench_hp_i64x8();
+    bench_hp_i64x8_simd();
+    bench_hp_f32x8();
+    bench_hp_f32x8_simd();
+    return 0;
+}
@@ -0,0 +1,117 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// Sorting and top-k selection on arrays of random ints: qsort, which calls
+// its comparison through a function pointer, against heap.c's _sort and
+// _partial_sort, where HP_CMP is inlined into the sift loops.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+#include "horror/macro.h"
+
+// A min-heap's comparison, so that _sort leaves the array ascending, like
+// qsort with the same comparison.
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_min
+#define HP_CMP(x, y) ((x) < (y))
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_min4
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_ARITY 4
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_min4_bu
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_ARITY 4
+#define HP_BOTTOM_UP
+#include "horror/heap.c"
+
+
+#define N 1000000
+#define K 100
+#define ROUNDS 5
+
+
+static int ascending(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+
+static void fill(int* array, uint64_t* seed) {
+    for (size_t i = 0; i < N; i++) {
+        array[i] = (int)(bench_rand(seed) >> 33);
+    }
+}
+
+
+#define BENCH(name, label, call)                                            \
+    static void HR_CONCAT(bench_, name)(int* array) {                       \
+        uint64_t seed = 42;                                                 \
+        double total = 0;                                                   \
+        for (size_t r = 0; r < ROUNDS; r++) {                               \
+            fill(array, &seed);                                             \
+            double start = bench_now();                                     \
+            call;                                                           \
+            total += bench_now() - start;                                   \
+            bench_sink += array[0];                                         \
+        }                                                                   \
+        bench_report(label, (size_t)N * ROUNDS, total);                     \
+    }
+
+BENCH(qsort, "qsort, n=1M", qsort(array, N, sizeof(int), ascending))
+BENCH(sort, "heap.c _sort, n=1M", hp_min_sort(array, N))
+BENCH(sort4, "heap.c HP_ARITY=4 _sort, n=1M", hp_min4_sort(array, N))
+BENCH(sort4_bu, "heap.c HP_ARITY=4 HP_BOTTOM_UP _sort, n=1M", hp_min4_bu_sort(array, N))
+BENCH(qsort_k, "qsort then take k, n=1M k=100", qsort(array, N, sizeof(int), ascending))
+BENCH(partial, "heap.c _partial_sort, n=1M k=100", hp_min_partial_sort(array, N, K))
+
+
+int main(void) {
+    int* array = malloc(N * sizeof(int));
+    bench_qsort(array);
+    bench_sort(array);
+    bench_sort4(array);
+    bench_sort4_bu(array);
+    bench_qsort_k(array);
+    bench_partial(array);
+    free(array);
+    return 0;
+}
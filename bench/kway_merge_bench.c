@@ -0,0 +1,161 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// Merging k sorted runs of uint64_t keys, N elements in all: the usual
+// heap-of-cursors loop written by hand with _extract and _insert, against
+// the merge's heap, which replaces its root in one sift-down, and its loser
+// tree. Output is taken a block of BLOCK elements at a time.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#include "horror/macro.h"
+
+#define KM_SCOPE HR_SCOPE_STATIC_INLINE
+#define KM_ELEM_TYPE uint64_t
+#define KM_NAME km_heap
+#define KM_CMP(x, y) ((x) < (y))
+#include "horror/kway_merge.c"
+
+#define KM_SCOPE HR_SCOPE_STATIC_INLINE
+#define KM_ELEM_TYPE uint64_t
+#define KM_NAME km_tree
+#define KM_CMP(x, y) ((x) < (y))
+#define KM_LOSER_TREE
+#include "horror/kway_merge.c"
+
+typedef struct {
+    const uint64_t* data;
+    size_t pos;
+    size_t len;
+} cursor_t;
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_BORROWED_INDIRECT
+#define HP_ELEM_TYPE cursor_t
+#define HP_NAME hp_cursor
+#define HP_CMP(x, y) ((x)->data[(x)->pos] < (y)->data[(y)->pos])
+#include "horror/heap.c"
+
+
+#define N 4000000
+#define BLOCK 256
+
+
+static uint64_t* keys;
+
+
+static int cmp_u64(const void* x, const void* y) {
+    uint64_t a = *(const uint64_t*)x, b = *(const uint64_t*)y;
+    return (a > b) - (a < b);
+}
+
+
+// Split `keys` into k runs of N / k and sort each.
+static void make_runs(size_t k) {
+    uint64_t seed = 42;
+
+    for (size_t i = 0; i < N; i++) {
+        keys[i] = bench_rand(&seed);
+    }
+
+    for (size_t i = 0; i < k; i++) {
+        qsort(keys + i * (N / k), N / k, sizeof(uint64_t), cmp_u64);
+    }
+}
+
+
+static void bench_by_hand(size_t k) {
+    hp_cursor_t hp;
+    cursor_t* cursors = malloc(k * sizeof(cursor_t));
+    char label[64];
+
+    if (cursors == NULL || !hp_cursor_init(&hp, k)) {
+        free(cursors);
+        return;
+    }
+
+    double start = bench_now();
+    for (size_t i = 0; i < k; i++) {
+        cursors[i] = (cursor_t){ keys + i * (N / k), 0, N / k };
+        hp_cursor_insert(&hp, &cursors[i]);
+    }
+    while (hp_cursor_size(&hp) > 0) {
+        cursor_t* c = hp_cursor_extract(&hp);
+        bench_sink += c->data[c->pos++];
+        if (c->pos < c->len) {
+            hp_cursor_insert(&hp, c);
+        }
+    }
+    snprintf(label, sizeof(label), "heap.c extract+insert loop, k=%zu", k);
+    bench_report(label, N, bench_now() - start);
+
+    hp_cursor_cleanup(&hp);
+    free(cursors);
+}
+
+
+#define BENCH(name, label_fmt)                                              \
+    static void HR_CONCAT(bench_, name)(size_t k) {                         \
+        HR_CONCAT(name, _t) km;                                             \
+        uint64_t out[BLOCK];                                                \
+        char label[64];                                                     \
+        size_t n;                                                           \
+        if (!HR_CONCAT(name, _init)(&km)) {                                 \
+            return;                                                         \
+        }                                                                   \
+        double start = bench_now();                                         \
+        for (size_t i = 0; i < k; i++) {                                    \
+            HR_CONCAT(name, _add_array)(&km, keys + i * (N / k), N / k);    \
+        }                                                                   \
+        while ((n = HR_CONCAT(name, _next)(&km, out, BLOCK)) > 0) {         \
+            bench_sink += out[n - 1];                                       \
+        }                                                                   \
+        snprintf(label, sizeof(label), label_fmt, k);                       \
+        bench_report(label, N, bench_now() - start);                        \
+        HR_CONCAT(name, _cleanup)(&km);                                     \
+    }
+
+BENCH(km_heap, "kway_merge.c heap, k=%zu")
+BENCH(km_tree, "kway_merge.c KM_LOSER_TREE, k=%zu")
+
+
+int main(void) {
+    keys = malloc(N * sizeof(uint64_t));
+
+    for (size_t k = 4; k <= 4096; k *= 8) {
+        make_runs(k);
+        bench_by_hand(k);
+        bench_km_heap(k);
+        bench_km_tree(k);
+    }
+
+    free(keys);
+    return 0;
+}
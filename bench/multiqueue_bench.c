@@ -0,0 +1,229 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// The multiqueue against a single heap behind a mutex, the usual way of
+// sharing one queue between worker threads. Each of P threads runs an equal
+// share of insert+extract pairs on a queue that starts out holding N
+// elements, with c * P shards for c = 2. Then, single-threaded, the rank
+// error of the multiqueue: for each extracted element, how many elements in
+// the queue came before it.
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+#include "horror/macro.h"
+
+#define MQ_SCOPE HR_SCOPE_STATIC_INLINE
+#define MQ_STORAGE HR_STORAGE_DIRECT
+#define MQ_ELEM_TYPE uint32_t
+#define MQ_NAME mq
+#define MQ_CMP(x, y) ((x) < (y))
+#include "horror/multiqueue.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE uint32_t
+#define HP_NAME hp
+#define HP_CMP(x, y) ((x) < (y))
+#include "horror/heap.c"
+
+
+#define N 1000000
+#define OPS 4000000
+#define C 2
+#define KEY_BITS 22
+
+
+typedef struct {
+    mq_t* mq;
+    hp_t* hp;
+    pthread_mutex_t* lock;
+    uint64_t seed;
+    size_t ops;
+} worker_t;
+
+
+static void* mq_work(void* arg) {
+    worker_t* w = arg;
+    uint64_t rng = w->seed;
+
+    for (size_t i = 0; i < w->ops; i++) {
+        uint32_t x;
+        mq_insert(w->mq, (uint32_t)(bench_rand(&w->seed) >> 40), &rng);
+        mq_extract(w->mq, &x, &rng);
+        bench_sink += x;
+    }
+
+    return NULL;
+}
+
+
+static void* hp_work(void* arg) {
+    worker_t* w = arg;
+
+    for (size_t i = 0; i < w->ops; i++) {
+        pthread_mutex_lock(w->lock);
+        hp_insert(w->hp, (uint32_t)(bench_rand(&w->seed) >> 40));
+        bench_sink += hp_extract(w->hp);
+        pthread_mutex_unlock(w->lock);
+    }
+
+    return NULL;
+}
+
+
+static void run(worker_t* workers, size_t p, void* (*fn)(void*), const char* label) {
+    pthread_t threads[64];
+    double start = bench_now();
+
+    for (size_t t = 0; t < p; t++) {
+        workers[t].seed = 42 + t;
+        workers[t].ops = OPS / p;
+        pthread_create(&threads[t], NULL, fn, &workers[t]);
+    }
+
+    for (size_t t = 0; t < p; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    bench_report(label, 2 * OPS, bench_now() - start);
+}
+
+
+static void bench_scaling(size_t p) {
+    worker_t workers[64];
+    char label[64];
+    uint64_t seed = 7, rng = 7;
+
+    mq_t mq;
+    if (!mq_init(&mq, C * p, N / (C * p))) {
+        return;
+    }
+    for (size_t i = 0; i < N; i++) {
+        mq_insert(&mq, (uint32_t)(bench_rand(&seed) >> 40), &rng);
+    }
+    for (size_t t = 0; t < p; t++) {
+        workers[t].mq = &mq;
+    }
+    snprintf(label, sizeof(label), "multiqueue, %zu threads", p);
+    run(workers, p, mq_work, label);
+    mq_cleanup(&mq);
+
+    hp_t hp;
+    pthread_mutex_t lock;
+    if (!hp_init(&hp, N)) {
+        return;
+    }
+    pthread_mutex_init(&lock, NULL);
+    for (size_t i = 0; i < N; i++) {
+        hp_insert(&hp, (uint32_t)(bench_rand(&seed) >> 40));
+    }
+    for (size_t t = 0; t < p; t++) {
+        workers[t].hp = &hp;
+        workers[t].lock = &lock;
+    }
+    snprintf(label, sizeof(label), "heap.c behind a mutex, %zu threads", p);
+    run(workers, p, hp_work, label);
+    hp_cleanup(&hp);
+    pthread_mutex_destroy(&lock);
+}
+
+
+// Fenwick tree over the key space, counting the keys in the queue, so the
+// rank of an extracted key is the count of keys below it.
+static uint32_t fenwick[(1 << KEY_BITS) + 1];
+
+static void fenwick_add(uint32_t key, int32_t d) {
+    for (size_t i = (size_t)key + 1; i <= (1 << KEY_BITS); i += i & -i) {
+        fenwick[i] += (uint32_t)d;
+    }
+}
+
+static uint32_t fenwick_below(uint32_t key) {
+    uint32_t sum = 0;
+    for (size_t i = key; i > 0; i -= i & -i) {
+        sum += fenwick[i];
+    }
+    return sum;
+}
+
+
+static void bench_rank_error(size_t p) {
+    uint64_t seed = 11, rng = 11;
+    mq_t mq;
+
+    memset(fenwick, 0, sizeof(fenwick));
+    if (!mq_init(&mq, C * p, 16)) {
+        return;
+    }
+
+    for (size_t i = 0; i < N; i++) {
+        uint32_t key = (uint32_t)(bench_rand(&seed) >> (64 - KEY_BITS));
+        mq_insert(&mq, key, &rng);
+        fenwick_add(key, 1);
+    }
+
+    uint64_t total = 0, worst = 0;
+    for (size_t i = 0; i < N; i++) {
+        uint32_t key;
+        mq_extract(&mq, &key, &rng);
+        fenwick_add(key, -1);
+
+        uint64_t rank = fenwick_below(key);
+        total += rank;
+        if (rank > worst) {
+            worst = rank;
+        }
+
+        key = (uint32_t)(bench_rand(&seed) >> (64 - KEY_BITS));
+        mq_insert(&mq, key, &rng);
+        fenwick_add(key, 1);
+    }
+
+    printf("multiqueue rank error, %2zu shards %18s %10.2f mean %8llu max\n",
+           C * p, "", (double)total / N, (unsigned long long)worst);
+    mq_cleanup(&mq);
+}
+
+
+int main(void) {
+    size_t p;
+
+    for (p = 1; p <= 8; p *= 2) {
+        bench_scaling(p);
+    }
+
+    for (p = 1; p <= 32; p *= 2) {
+        bench_rank_error(p);
+    }
+
+    return 0;
+}
@@ -0,0 +1,281 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// Pairing heap against heap.c: a round of N random inserts followed by N
+// extracts, a decrease-key heavy round (N inserts, 4N decrease-keys, N
+// extracts) against an HP_INDEXED heap, and the two workloads where O(1)
+// insertion and melding ought to pay off: N inserts of descending keys (each
+// of which heap.c has to sift all the way to the root) followed by N / 100
+// extracts, and melding MELDS heaps of N / MELDS elements into one, followed
+// by N / 100 extracts, where heap.c melds by appending each heap's array. The
+// meld and the extracts after it are timed apart, since a pairing heap pays
+// for a cheap meld with more work on the extracts that follow.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#include "horror/macro.h"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE uint64_t
+#define HP_NAME hp_u64
+#define HP_CMP(x, y) ((x) < (y))
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE uint64_t
+#define HP_NAME hp_idx
+#define HP_CMP(x, y) ((x) < (y))
+#define HP_INDEXED
+#include "horror/heap.c"
+
+#define PH_SCOPE HR_SCOPE_STATIC_INLINE
+#define PH_STORAGE HR_STORAGE_DIRECT
+#define PH_ELEM_TYPE uint64_t
+#define PH_NAME ph_u64
+#define PH_CMP(x, y) ((x) < (y))
+#include "horror/pairing_heap.c"
+
+
+#define N 1000000
+#define DECREASES (4 * N)
+#define MELDS 1000
+#define FEW (N / 100)
+
+
+static void bench_heap(void) {
+    hp_u64_t hp;
+    uint64_t seed = 42;
+    if (!hp_u64_init(&hp, 16)) {
+        return;
+    }
+
+    double start = bench_now();
+    for (size_t i = 0; i < N; i++) {
+        hp_u64_insert(&hp, bench_rand(&seed) >> 1);
+    }
+    for (size_t i = 0; i < N; i++) {
+        bench_sink += hp_u64_extract(&hp);
+    }
+    bench_report("heap.c insert+extract", 2 * N, bench_now() - start);
+
+    hp_u64_cleanup(&hp);
+}
+
+
+static void bench_pairing(void) {
+    ph_u64_t ph;
+    uint64_t seed = 42;
+    ph_u64_init(&ph);
+
+    double start = bench_now();
+    for (size_t i = 0; i < N; i++) {
+        ph_u64_insert(&ph, bench_rand(&seed) >> 1);
+    }
+    for (size_t i = 0; i < N; i++) {
+        bench_sink += ph_u64_extract(&ph);
+    }
+    bench_report("pairing_heap.c insert+extract", 2 * N, bench_now() - start);
+
+    ph_u64_cleanup(&ph);
+}
+
+
+static void bench_heap_decrease(void) {
+    hp_idx_t hp;
+    uint64_t seed = 42;
+    size_t* handles = malloc(N * sizeof(size_t));
+    if (handles == NULL || !hp_idx_init(&hp, 16)) {
+        free(handles);
+        return;
+    }
+
+    double start = bench_now();
+    for (size_t i = 0; i < N; i++) {
+        hp_idx_insert(&hp, bench_rand(&seed) >> 1, &handles[i]);
+    }
+    for (size_t i = 0; i < DECREASES; i++) {
+        size_t h = handles[bench_rand(&seed) % N];
+        *hp_idx_get(&hp, h) >>= 1;
+        hp_idx_decrease_key(&hp, h);
+    }
+    for (size_t i = 0; i < N; i++) {
+        bench_sink += hp_idx_extract(&hp);
+    }
+    bench_report("heap.c HP_INDEXED decrease-key round", 2 * N + DECREASES, bench_now() - start);
+
+    hp_idx_cleanup(&hp);
+    free(handles);
+}
+
+
+static void bench_pairing_decrease(void) {
+    ph_u64_t ph;
+    uint64_t seed = 42;
+    ph_u64_node_t** nodes = malloc(N * sizeof(ph_u64_node_t*));
+    ph_u64_init(&ph);
+
+    double start = bench_now();
+    for (size_t i = 0; i < N; i++) {
+        nodes[i] = ph_u64_insert(&ph, bench_rand(&seed) >> 1);
+    }
+    for (size_t i = 0; i < DECREASES; i++) {
+        ph_u64_node_t* node = nodes[bench_rand(&seed) % N];
+        *ph_u64_get(node) >>= 1;
+        ph_u64_decrease_key(&ph, node);
+    }
+    for (size_t i = 0; i < N; i++) {
+        bench_sink += ph_u64_extract(&ph);
+    }
+    bench_report("pairing_heap.c decrease-key round", 2 * N + DECREASES, bench_now() - start);
+
+    ph_u64_cleanup(&ph);
+    free(nodes);
+}
+
+
+static void bench_heap_descending(void) {
+    hp_u64_t hp;
+    if (!hp_u64_init(&hp, 16)) {
+        return;
+    }
+
+    double start = bench_now();
+    for (size_t i = 0; i < N; i++) {
+        hp_u64_insert(&hp, N - i);
+    }
+    for (size_t i = 0; i < FEW; i++) {
+        bench_sink += hp_u64_extract(&hp);
+    }
+    bench_report("heap.c descending inserts, few extracts", N + FEW, bench_now() - start);
+
+    hp_u64_cleanup(&hp);
+}
+
+
+static void bench_pairing_descending(void) {
+    ph_u64_t ph;
+    ph_u64_init(&ph);
+
+    double start = bench_now();
+    for (size_t i = 0; i < N; i++) {
+        ph_u64_insert(&ph, N - i);
+    }
+    for (size_t i = 0; i < FEW; i++) {
+        bench_sink += ph_u64_extract(&ph);
+    }
+    bench_report("pairing_heap.c descending inserts, few extracts", N + FEW, bench_now() - start);
+
+    ph_u64_cleanup(&ph);
+}
+
+
+static void bench_heap_meld(void) {
+    hp_u64_t hp;
+    uint64_t seed = 42;
+    uint64_t* parts = malloc(N * sizeof(uint64_t));
+    if (parts == NULL || !hp_u64_init(&hp, 16)) {
+        free(parts);
+        return;
+    }
+
+    // Each part is a valid heap as it is: ascending runs are heap-ordered.
+    for (size_t i = 0; i < N; i++) {
+        parts[i] = bench_rand(&seed) >> 1;
+    }
+    for (size_t k = 0; k < MELDS; k++) {
+        hp_u64_sort(&parts[k * (N / MELDS)], N / MELDS);
+    }
+
+    double start = bench_now();
+    for (size_t k = 0; k < MELDS; k++) {
+        hp_u64_insert_many(&hp, &parts[k * (N / MELDS)], N / MELDS);
+    }
+    bench_report("heap.c meld", MELDS, bench_now() - start);
+
+    start = bench_now();
+    for (size_t i = 0; i < FEW; i++) {
+        bench_sink += hp_u64_extract(&hp);
+    }
+    bench_report("heap.c extracts after meld", FEW, bench_now() - start);
+
+    hp_u64_cleanup(&hp);
+    free(parts);
+}
+
+
+static void bench_pairing_meld(void) {
+    uint64_t seed = 42;
+    ph_u64_t* parts = malloc(MELDS * sizeof(ph_u64_t));
+    if (parts == NULL) {
+        return;
+    }
+
+    for (size_t k = 0; k < MELDS; k++) {
+        ph_u64_init(&parts[k]);
+        for (size_t i = 0; i < N / MELDS; i++) {
+            ph_u64_insert(&parts[k], bench_rand(&seed) >> 1);
+        }
+
+        // A pairing heap that's only seen insertions is its root with every
+        // other node as a child; extract once to pair them up, as they would
+        // be in a heap that's in use.
+        ph_u64_insert(&parts[k], ph_u64_extract(&parts[k]));
+    }
+
+    double start = bench_now();
+    for (size_t k = 1; k < MELDS; k++) {
+        ph_u64_meld(&parts[0], &parts[k]);
+    }
+    bench_report("pairing_heap.c meld", MELDS, bench_now() - start);
+
+    start = bench_now();
+    for (size_t i = 0; i < FEW; i++) {
+        bench_sink += ph_u64_extract(&parts[0]);
+    }
+    bench_report("pairing_heap.c extracts after meld", FEW, bench_now() - start);
+
+    ph_u64_cleanup(&parts[0]);
+    free(parts);
+}
+
+
+int main(void) {
+    bench_heap();
+    bench_pairing();
+    bench_heap_decrease();
+    bench_pairing_decrease();
+    bench_heap_descending();
+    bench_pairing_descending();
+    bench_heap_meld();
+    bench_pairing_meld();
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// Radix heap against heap.c on monotone workloads: a simulation-style hold
+// model which keeps N events pending, each extract rescheduling an event a
+// random delay after the current time, followed by draining the queue.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#include "horror/macro.h"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE uint64_t
+#define HP_NAME hp_u64
+#define HP_CMP(x, y) ((x) < (y))
+#include "horror/heap.c"
+
+#define RX_SCOPE HR_SCOPE_STATIC_INLINE
+#define RX_STORAGE HR_STORAGE_DIRECT
+#define RX_ELEM_TYPE uint64_t
+#define RX_NAME rx_u64
+#define RX_KEY(x) (x)
+#include "horror/radix_heap.c"
+
+
+#define ROUNDS (4 * 1000000)
+
+
+// `init` is false if the queue couldn't be set up. The radix heap's _init
+// can't fail, so its call is paired with `true`.
+#define BENCH(name, label, init)                                            \
+    static void HR_CONCAT(bench_, name)(size_t pending, uint64_t range) {   \
+        HR_CONCAT(name, _t) q;                                              \
+        uint64_t seed = 42, now = 0;                                        \
+        if (!(init)) {                                                      \
+            return;                                                         \
+        }                                                                   \
+        for (size_t i = 0; i < pending; i++) {                              \
+            HR_CONCAT(name, _insert)(&q, bench_rand(&seed) % range);        \
+        }                                                                   \
+        double start = bench_now();                                         \
+        for (size_t i = 0; i < ROUNDS; i++) {                               \
+            now = HR_CONCAT(name, _extract)(&q);                            \
+            HR_CONCAT(name, _insert)(&q, now + bench_rand(&seed) % range);  \
+        }                                                                   \
+        while (HR_CONCAT(name, _size)(&q) > 0) {                            \
+            bench_sink += HR_CONCAT(name, _extract)(&q);                    \
+        }                                                                   \
+        char buf[64];                                                       \
+        snprintf(buf, sizeof(buf), "%s n=%zu", label, pending);             \
+        bench_report(buf, 2 * ROUNDS + pending, bench_now() - start);       \
+        HR_CONCAT(name, _cleanup)(&q);                                      \
+    }
+
+BENCH(hp_u64, "heap.c hold", hp_u64_init(&q, 16))
+BENCH(rx_u64, "radix_heap.c hold", (rx_u64_init(&q), true))
+
+
+int main(void) {
+    size_t sizes[] = { 1000, 100000, 1000000 };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        bench_hp_u64(sizes[i], 1 << 20);
+        bench_rx_u64(sizes[i], 1 << 20);
+    }
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+// Timer wheel against an HP_INDEXED heap of deadlines, on connection
+// timeouts: N connections whose timeouts are pushed back on every bit of
+// traffic, and churn where short-lived connections arm a timer and almost
+// always cancel it before it fires.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#include "horror/macro.h"
+
+typedef struct {
+    uint64_t deadline;
+    uint32_t conn;
+} timeout_t;
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE timeout_t
+#define HP_NAME hp_timeout
+#define HP_CMP(x, y) ((x).deadline < (y).deadline)
+#define HP_INDEXED
+#include "horror/heap.c"
+
+#define TW_SCOPE HR_SCOPE_STATIC_INLINE
+#define TW_STORAGE HR_STORAGE_DIRECT
+#define TW_ELEM_TYPE uint32_t
+#define TW_NAME tw_conn
+#include "horror/timer_wheel.c"
+
+
+#define N 1000000
+#define TICKS 20000
+#define PER_TICK 200
+#define TIMEOUT 30000
+
+
+static void bench_heap_refresh(void) {
+    hp_timeout_t hp;
+    uint64_t seed = 42;
+    size_t* handles = malloc(N * sizeof(size_t));
+    if (handles == NULL || !hp_timeout_init(&hp, N)) {
+        free(handles);
+        return;
+    }
+
+    double start = bench_now();
+    for (uint32_t i = 0; i < N; i++) {
+        timeout_t t = { bench_rand(&seed) % TIMEOUT, i };
+        hp_timeout_insert(&hp, t, &handles[i]);
+    }
+    for (uint64_t now = 1; now <= TICKS; now++) {
+        for (size_t i = 0; i < PER_TICK; i++) {
+            size_t h = handles[bench_rand(&seed) % N];
+            hp_timeout_get(&hp, h)->deadline = now + TIMEOUT;
+            hp_timeout_increase_key(&hp, h);
+        }
+        while (hp_timeout_peek(&hp)->deadline <= now) {
+            // The connection times out and is replaced by a fresh one.
+            timeout_t t = hp_timeout_extract(&hp);
+            t.deadline = now + TIMEOUT;
+            hp_timeout_insert(&hp, t, &handles[t.conn]);
+            bench_sink += t.conn;
+        }
+    }
+    bench_report("heap.c HP_INDEXED refresh", N + TICKS * PER_TICK, bench_now() - start);
+
+    hp_timeout_cleanup(&hp);
+    free(handles);
+}
+
+
+static void bench_wheel_refresh(void) {
+    tw_conn_t tw;
+    uint64_t seed = 42;
+    tw_conn_timer_t** timers = malloc(N * sizeof(tw_conn_timer_t*));
+    uint32_t fired[256];
+    if (timers == NULL || !tw_conn_init(&tw, 0)) {
+        free(timers);
+        return;
+    }
+
+    double start = bench_now();
+    for (uint32_t i = 0; i < N; i++) {
+        timers[i] = tw_conn_arm(&tw, bench_rand(&seed) % TIMEOUT, i);
+    }
+    for (uint64_t now = 1; now <= TICKS; now++) {
+        for (size_t i = 0; i < PER_TICK; i++) {
+            tw_conn_rearm(&tw, timers[bench_rand(&seed) % N], now + TIMEOUT);
+        }
+        size_t n;
+        do {
+            n = tw_conn_advance(&tw, now, fired, 256);
+            for (size_t i = 0; i < n; i++) {
+                timers[fired[i]] = tw_conn_arm(&tw, now + TIMEOUT, fired[i]);
+                bench_sink += fired[i];
+            }
+        } while (n == 256);
+    }
+    bench_report("timer_wheel.c refresh", N + TICKS * PER_TICK, bench_now() - start);
+
+    tw_conn_cleanup(&tw);
+    free(timers);
+}
+
+
+// Every tick, PER_TICK connections open and arm a timeout, and 95% of the
+// connections opened TIMEOUT / 10 ticks earlier close and cancel theirs.
+static void bench_heap_churn(void) {
+    hp_timeout_t hp;
+    uint64_t seed = 42;
+    size_t window = PER_TICK * (TIMEOUT / 10);
+    size_t* handles = malloc(window * sizeof(size_t));
+    bool* live = calloc(window, sizeof(bool));
+    if (handles == NULL || live == NULL || !hp_timeout_init(&hp, 16)) {
+        free(handles);
+        free(live);
+        return;
+    }
+
+    double start = bench_now();
+    for (uint64_t now = 1; now <= TICKS; now++) {
+        for (size_t i = 0; i < PER_TICK; i++) {
+            size_t slot = (now * PER_TICK + i) % window;
+            if (live[slot] && bench_rand(&seed) % 20 != 0) {
+                hp_timeout_remove(&hp, handles[slot]);
+            }
+            timeout_t t = { now + TIMEOUT, (uint32_t)slot };
+            hp_timeout_insert(&hp, t, &handles[slot]);
+            live[slot] = true;
+        }
+        while (hp_timeout_size(&hp) > 0 && hp_timeout_peek(&hp)->deadline <= now) {
+            bench_sink += hp_timeout_extract(&hp).conn;
+        }
+    }
+    bench_report("heap.c HP_INDEXED arm+cancel churn", 2 * TICKS * PER_TICK, bench_now() - start);
+
+    hp_timeout_cleanup(&hp);
+    free(handles);
+    free(live);
+}
+
+
+static void bench_wheel_churn(void) {
+    tw_conn_t tw;
+    uint64_t seed = 42;
+    size_t window = PER_TICK * (TIMEOUT / 10);
+    tw_conn_timer_t** timers = calloc(window, sizeof(tw_conn_timer_t*));
+    uint32_t fired[256];
+    if (timers == NULL || !tw_conn_init(&tw, 0)) {
+        free(timers);
+        return;
+    }
+
+    double start = bench_now();
+    for (uint64_t now = 1; now <= TICKS; now++) {
+        for (size_t i = 0; i < PER_TICK; i++) {
+            size_t slot = (now * PER_TICK + i) % window;
+            if (timers[slot] != NULL && bench_rand(&seed) % 20 != 0) {
+                tw_conn_cancel(&tw, timers[slot]);
+            }
+            timers[slot] = tw_conn_arm(&tw, now + TIMEOUT, (uint32_t)slot);
+        }
+        size_t n;
+        do {
+            n = tw_conn_advance(&tw, now, fired, 256);
+            for (size_t i = 0; i < n; i++) {
+                bench_sink += fired[i];
+            }
+        } while (n == 256);
+    }
+    bench_report("timer_wheel.c arm+cancel churn", 2 * TICKS * PER_TICK, bench_now() - start);
+
+    tw_conn_cleanup(&tw);
+    free(timers);
+}
+
+
+int main(void) {
+    bench_heap_refresh();
+    bench_wheel_refresh();
+    bench_heap_churn();
+    bench_wheel_churn();
+    return 0;
+}
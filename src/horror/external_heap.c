@@ -0,0 +1,599 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "horror/macro.h"
+
+
+#if !defined(EH_ELEM_TYPE)
+    #error Error: Generic external heap requires EH_ELEM_TYPE to be defined. \
+Elements are written to disk byte for byte, so it must be plain data.
+    #define EH_ELEM_TYPE int // For purposes of testing.
+#endif
+
+#if !defined(EH_NAME)
+    #error Error: Generic external heap requires EH_NAME to be defined. It \
+can not use the type, since it might be a pointer.
+    #define EH_NAME eh_int // For purposes of testing.
+#endif
+
+#if !defined(EH_CMP)
+    #error Error: Generic external heap requires EH_CMP to be defined. EH_CMP \
+works like HP_CMP in horror/heap.c with direct storage.
+    #define EH_CMP(x, y) ((x) < (y)) // For purposes of testing.
+#endif
+
+#if !defined(EH_TYPE)
+    #define EH_TYPE HR_CONCAT(EH_NAME, _t)
+#endif
+
+// Runs are written and read this many bytes at a time.
+#if !defined(EH_BLOCK_BYTES)
+    #define EH_BLOCK_BYTES 65536
+#endif
+
+// Opens a new, empty temporary file for a run, open for reading and writing
+// in binary mode, which goes away once closed.
+#if !defined(EH_TMPFILE)
+    #define EH_TMPFILE() tmpfile()
+#endif
+
+
+#if EH_SCOPE == HR_SCOPE_NONE
+    #define EH_FUNC
+#elif EH_SCOPE == HR_SCOPE_STATIC
+    #define EH_FUNC static
+#elif EH_SCOPE == HR_SCOPE_STATIC_INLINE
+    #define EH_FUNC static inline
+#elif EH_SCOPE == HR_SCOPE_EXTERN_INLINE
+    #define EH_FUNC extern inline
+#else
+    #error Error: Generic external heap requires EH_SCOPE to be defined.
+    #define EH_FUNC // For testing purposes.
+#endif
+
+#define EH_MEM HR_CONCAT(EH_NAME, _mem)
+#define EH_MERGE HR_CONCAT(EH_NAME, _merge)
+#define EH_RUN HR_CONCAT(EH_NAME, _run_t)
+
+#define EH_BLOCK (EH_BLOCK_BYTES / sizeof(EH_ELEM_TYPE) > 0 ? EH_BLOCK_BYTES / sizeof(EH_ELEM_TYPE) : 1)
+
+
+typedef struct EH_TYPE EH_TYPE;
+
+
+#if EH_SCOPE != HR_SCOPE_HEADER && EH_SCOPE != HR_SCOPE_EXTERN_INLINE
+
+// A sorted run: whatever's left of it in `file`, read a block at a time into
+// `block`, whose next element is at `pos`. A run may also live in `block`
+// alone, with no file behind it.
+typedef struct EH_RUN {
+    FILE* file;
+    EH_ELEM_TYPE* block;
+    size_t pos;
+    size_t fill;
+    size_t left;
+} EH_RUN;
+
+
+#define HP_SCOPE EH_SCOPE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE EH_ELEM_TYPE
+#define HP_NAME EH_MEM
+#define HP_CMP(x, y) EH_CMP(x, y)
+#include "horror/heap.c"
+
+#define HP_SCOPE EH_SCOPE
+#define HP_STORAGE HR_STORAGE_BORROWED_INDIRECT
+#define HP_ELEM_TYPE EH_RUN
+#define HP_NAME EH_MERGE
+#define HP_CMP(x, y) EH_CMP(((x)->block[(x)->pos]), ((y)->block[(y)->pos]))
+#include "horror/heap.c"
+
+#endif
+
+#define NAME_(n) HR_CONCAT(EH_NAME, n)
+
+
+EH_FUNC bool NAME_(_init)(EH_TYPE* eh, size_t budget);
+EH_FUNC void NAME_(_cleanup)(EH_TYPE* eh);
+EH_FUNC bool NAME_(_insert)(EH_TYPE* eh, EH_ELEM_TYPE elem);
+EH_FUNC bool NAME_(_extract)(EH_TYPE* eh, EH_ELEM_TYPE* out);
+EH_FUNC EH_ELEM_TYPE* NAME_(_peek)(EH_TYPE* eh);
+EH_FUNC size_t NAME_(_size)(EH_TYPE* eh);
+EH_FUNC size_t NAME_(_runs)(EH_TYPE* eh);
+EH_FUNC size_t NAME_(_written)(EH_TYPE* eh);
+EH_FUNC bool NAME_(_failed)(EH_TYPE* eh);
+
+#if EH_SCOPE != HR_SCOPE_HEADER && EH_SCOPE != HR_SCOPE_EXTERN_INLINE
+
+// An external-memory priority queue. New elements go into an in-memory heap
+// of at most `_mem_cap` elements; when it fills, its contents are written out
+// in order as a run. The runs' next elements sit in a merge heap, and the
+// least of its root and the in-memory heap's root is the queue's front. Once
+// there are `_max_runs` runs, the smallest few are merged into one before
+// another is written, so that only a bounded number of blocks are ever held
+// in memory.
+struct EH_TYPE {
+    HR_CONCAT(EH_MEM, _t) _mem;
+    HR_CONCAT(EH_MERGE, _t) _merge;
+    size_t _mem_cap;
+    size_t _max_runs;
+    EH_ELEM_TYPE* _out;
+    size_t _used;
+    size_t _written;
+    bool _failed;
+};
+
+
+// Half of `budget` goes to the in-memory heap and half to blocks: one for
+// writing runs, and one for reading each run.
+EH_FUNC bool NAME_(_init)(EH_TYPE* eh, size_t budget) {
+    size_t block_bytes = EH_BLOCK * sizeof(EH_ELEM_TYPE);
+
+    eh->_mem_cap = budget / 2 / sizeof(EH_ELEM_TYPE);
+    eh->_max_runs = budget / 2 / block_bytes;
+
+    if (eh->_mem_cap < 1) {
+        eh->_mem_cap = 1;
+    }
+
+    eh->_max_runs = eh->_max_runs > 3 ? eh->_max_runs - 1 : 2;
+
+    if (!HR_CONCAT(EH_MEM, _init)(&eh->_mem, eh->_mem_cap)) {
+        return false;
+    }
+
+    if (!HR_CONCAT(EH_MERGE, _init)(&eh->_merge, eh->_max_runs + 2)) {
+        HR_CONCAT(EH_MEM, _cleanup)(&eh->_mem);
+        return false;
+    }
+
+    eh->_out = NULL;
+    eh->_used = 0;
+    eh->_written = 0;
+    eh->_failed = false;
+
+    return true;
+}
+
+
+EH_FUNC void NAME_(_close_run)(EH_RUN* run) {
+    if (run->file != NULL) {
+        fclose(run->file);
+    }
+
+    free(run->block);
+    free(run);
+}
+
+
+EH_FUNC void NAME_(_cleanup)(EH_TYPE* eh) {
+    while (HR_CONCAT(EH_MERGE, _size)(&eh->_merge) > 0) {
+        NAME_(_close_run)(HR_CONCAT(EH_MERGE, _extract)(&eh->_merge));
+    }
+
+    HR_CONCAT(EH_MERGE, _cleanup)(&eh->_merge);
+    HR_CONCAT(EH_MEM, _cleanup)(&eh->_mem);
+    free(eh->_out);
+}
+
+
+// Read the next block of `run`. Returns false if there's nothing left of it,
+// or if the read fails.
+EH_FUNC bool NAME_(_refill)(EH_TYPE* eh, EH_RUN* run) {
+    size_t want = run->left < EH_BLOCK ? run->left : EH_BLOCK;
+
+    if (want == 0) {
+        return false;
+    }
+
+    run->pos = 0;
+    run->fill = fread(run->block, sizeof(EH_ELEM_TYPE), want, run->file);
+    run->left -= want;
+
+    if (run->fill < want) {
+        eh->_failed = true;
+        eh->_used -= want - run->fill + run->left;
+        run->left = 0;
+    }
+
+    return run->fill > 0;
+}
+
+
+// Start reading a run which has `count` elements in `file`, or which is
+// `block`, holding `fill` elements, by itself. If it can't, the run's
+// elements are lost; it's closed, and the heap marked as failed.
+EH_FUNC bool NAME_(_add_run)(EH_TYPE* eh, FILE* file, size_t count, EH_ELEM_TYPE* block, size_t fill) {
+    EH_RUN* run = (EH_RUN*)malloc(sizeof(EH_RUN));
+
+    if (run == NULL) {
+        if (file != NULL) {
+            fclose(file);
+        }
+        free(block);
+        eh->_failed = true;
+        eh->_used -= count + fill;
+        return false;
+    }
+
+    run->file = file;
+    run->block = block;
+    run->pos = 0;
+    run->fill = fill;
+    run->left = count;
+
+    if (file != NULL) {
+        run->block = (EH_ELEM_TYPE*)malloc(EH_BLOCK * sizeof(EH_ELEM_TYPE));
+
+        if (run->block == NULL || fseek(file, 0, SEEK_SET) != 0) {
+            eh->_failed = true;
+            eh->_used -= count;
+            NAME_(_close_run)(run);
+            return false;
+        }
+
+        if (!NAME_(_refill)(eh, run)) {
+            NAME_(_close_run)(run);
+            return false;
+        }
+    }
+
+    if (!HR_CONCAT(EH_MERGE, _insert)(&eh->_merge, run)) {
+        eh->_failed = true;
+        eh->_used -= run->fill + run->left;
+        NAME_(_close_run)(run);
+        return false;
+    }
+
+    return true;
+}
+
+
+// Move past the front element of the run at the root of the merge heap.
+EH_FUNC void NAME_(_advance)(EH_TYPE* eh) {
+    EH_RUN* run = HR_CONCAT(EH_MERGE, _peek)(&eh->_merge);
+
+    if (++run->pos < run->fill || NAME_(_refill)(eh, run)) {
+        HR_CONCAT(EH_MERGE, _replace)(&eh->_merge, run);
+    } else {
+        NAME_(_close_run)(HR_CONCAT(EH_MERGE, _extract)(&eh->_merge));
+    }
+}
+
+
+// A new, empty, unbuffered temporary file; runs are only ever read and
+// written a whole block at a time.
+EH_FUNC FILE* NAME_(_new_file)(void) {
+    FILE* file = EH_TMPFILE();
+
+    if (file != NULL) {
+        setvbuf(file, NULL, _IONBF, 0);
+    }
+
+    return file;
+}
+
+
+// Write out `n` elements from the output block. On failure, the elements
+// already in `file` are sound, and the output block is left as it was.
+EH_FUNC bool NAME_(_write)(EH_TYPE* eh, FILE* file, size_t n) {
+    if (fwrite(eh->_out, sizeof(EH_ELEM_TYPE), n, file) != n) {
+        eh->_failed = true;
+        return false;
+    }
+
+    eh->_written += n;
+
+    return true;
+}
+
+
+EH_FUNC size_t NAME_(_run_size)(const EH_RUN* run) {
+    return run->fill - run->pos + run->left;
+}
+
+
+EH_FUNC int NAME_(_run_cmp)(const void* a, const void* b) {
+    size_t x = NAME_(_run_size)(*(EH_RUN* const*)a);
+    size_t y = NAME_(_run_size)(*(EH_RUN* const*)b);
+    return (x > y) - (x < y);
+}
+
+
+// Put a run set aside by _merge_runs back into the merge heap. If it can't,
+// the run's elements are lost, as in _add_run.
+EH_FUNC void NAME_(_put_back)(EH_TYPE* eh, EH_RUN* run) {
+    if (!HR_CONCAT(EH_MERGE, _insert)(&eh->_merge, run)) {
+        eh->_failed = true;
+        eh->_used -= NAME_(_run_size)(run);
+        NAME_(_close_run)(run);
+    }
+}
+
+
+// Merge the smallest runs into one: at least two, and then each next
+// smallest as long as it's no bigger than those taken so far put together.
+// Merging everything would rewrite the biggest run, and with it most of the
+// data, every few spills; this way runs are only merged with others of about
+// their size, like a binary counter, and each element is rewritten about
+// log(N / _mem_cap) times. If there's no memory to sort the runs by size,
+// they're all merged after all. If writing fails, whatever was written becomes a
+// run of its own, and so does the block which couldn't be written, so that
+// nothing is lost.
+EH_FUNC bool NAME_(_merge_runs)(EH_TYPE* eh) {
+    FILE* file = NAME_(_new_file)();
+
+    if (file == NULL) {
+        eh->_failed = true;
+        return false;
+    }
+
+    size_t count = HR_CONCAT(EH_MERGE, _size)(&eh->_merge), take = count;
+    EH_RUN** by_size = (EH_RUN**)malloc(count * sizeof(EH_RUN*));
+
+    if (by_size != NULL) {
+        for (size_t i = 0; i < count; i++) {
+            by_size[i] = HR_CONCAT(EH_MERGE, _extract)(&eh->_merge);
+        }
+
+        qsort(by_size, count, sizeof(EH_RUN*), NAME_(_run_cmp));
+
+        size_t total = 0;
+
+        for (take = 0; take < count; take++) {
+            size_t size = NAME_(_run_size)(by_size[take]);
+
+            if (take >= 2 && size > total) {
+                break;
+            }
+
+            total += size;
+        }
+
+        // These were just taken out, so there's room for them.
+        for (size_t i = 0; i < take; i++) {
+            HR_CONCAT(EH_MERGE, _insert)(&eh->_merge, by_size[i]);
+        }
+    }
+
+    size_t written = 0, n = 0;
+
+    while (HR_CONCAT(EH_MERGE, _size)(&eh->_merge) > 0) {
+        EH_RUN* run = HR_CONCAT(EH_MERGE, _peek)(&eh->_merge);
+        eh->_out[n++] = run->block[run->pos];
+        NAME_(_advance)(eh);
+
+        if (n == EH_BLOCK) {
+            if (!NAME_(_write)(eh, file, n)) {
+                break;
+            }
+
+            written += n;
+            n = 0;
+        }
+    }
+
+    bool ok = HR_CONCAT(EH_MERGE, _size)(&eh->_merge) == 0;
+
+    if (ok && n > 0) {
+        ok = NAME_(_write)(eh, file, n);
+        if (ok) {
+            written += n;
+            n = 0;
+        }
+    }
+
+    if (written > 0) {
+        NAME_(_add_run)(eh, file, written, NULL, 0);
+    } else {
+        fclose(file);
+    }
+
+    if (n > 0) {
+        NAME_(_add_run)(eh, NULL, 0, eh->_out, n);
+        eh->_out = NULL;
+    }
+
+    if (by_size != NULL) {
+        for (size_t i = take; i < count; i++) {
+            NAME_(_put_back)(eh, by_size[i]);
+        }
+
+        free(by_size);
+    }
+
+    return ok;
+}
+
+
+// Write the in-memory heap out as a new run, merging the existing runs
+// first if there are too many of them. If writing fails, the block which
+// couldn't be written goes back into the heap.
+EH_FUNC bool NAME_(_spill)(EH_TYPE* eh) {
+    if (eh->_out == NULL) {
+        eh->_out = (EH_ELEM_TYPE*)malloc(EH_BLOCK * sizeof(EH_ELEM_TYPE));
+
+        if (eh->_out == NULL) {
+            return false;
+        }
+    }
+
+    if (HR_CONCAT(EH_MERGE, _size)(&eh->_merge) >= eh->_max_runs && !NAME_(_merge_runs)(eh)) {
+        return false;
+    }
+
+    FILE* file = NAME_(_new_file)();
+
+    if (file == NULL) {
+        eh->_failed = true;
+        return false;
+    }
+
+    size_t written = 0;
+    bool ok = true;
+
+    while (ok && HR_CONCAT(EH_MEM, _size)(&eh->_mem) > 0) {
+        size_t n = 0;
+
+        while (n < EH_BLOCK && HR_CONCAT(EH_MEM, _size)(&eh->_mem) > 0) {
+            eh->_out[n++] = HR_CONCAT(EH_MEM, _extract)(&eh->_mem);
+        }
+
+        ok = NAME_(_write)(eh, file, n);
+
+        if (ok) {
+            written += n;
+        } else {
+            HR_CONCAT(EH_MEM, _insert_many)(&eh->_mem, eh->_out, n);
+        }
+    }
+
+    if (written > 0) {
+        ok = NAME_(_add_run)(eh, file, written, NULL, 0) && ok;
+    } else {
+        fclose(file);
+    }
+
+    return ok;
+}
+
+
+// Returns false if the element couldn't be stored, either for lack of memory
+// or because a run couldn't be written.
+EH_FUNC bool NAME_(_insert)(EH_TYPE* eh, EH_ELEM_TYPE elem) {
+    if (HR_CONCAT(EH_MEM, _size)(&eh->_mem) >= eh->_mem_cap && !NAME_(_spill)(eh)) {
+        return false;
+    }
+
+    if (!HR_CONCAT(EH_MEM, _insert)(&eh->_mem, elem)) {
+        return false;
+    }
+
+    eh->_used++;
+
+    return true;
+}
+
+
+// Whether the front of the queue is the root of the merge heap, rather than
+// the in-memory heap.
+EH_FUNC bool NAME_(_front_on_disk)(EH_TYPE* eh) {
+    if (HR_CONCAT(EH_MERGE, _size)(&eh->_merge) == 0) {
+        return false;
+    }
+
+    if (HR_CONCAT(EH_MEM, _size)(&eh->_mem) == 0) {
+        return true;
+    }
+
+    EH_RUN* run = HR_CONCAT(EH_MERGE, _peek)(&eh->_merge);
+
+    return EH_CMP((run->block[run->pos]), (*HR_CONCAT(EH_MEM, _peek)(&eh->_mem)));
+}
+
+
+EH_FUNC EH_ELEM_TYPE* NAME_(_peek)(EH_TYPE* eh) {
+    if (NAME_(_front_on_disk)(eh)) {
+        EH_RUN* run = HR_CONCAT(EH_MERGE, _peek)(&eh->_merge);
+        return &run->block[run->pos];
+    }
+
+    if (HR_CONCAT(EH_MEM, _size)(&eh->_mem) > 0) {
+        return HR_CONCAT(EH_MEM, _peek)(&eh->_mem);
+    }
+
+    return NULL;
+}
+
+
+// Take the front of the queue into `out`. Returns false if the queue is
+// empty.
+EH_FUNC bool NAME_(_extract)(EH_TYPE* eh, EH_ELEM_TYPE* out) {
+    if (NAME_(_front_on_disk)(eh)) {
+        EH_RUN* run = HR_CONCAT(EH_MERGE, _peek)(&eh->_merge);
+        *out = run->block[run->pos];
+        NAME_(_advance)(eh);
+    } else if (HR_CONCAT(EH_MEM, _size)(&eh->_mem) > 0) {
+        *out = HR_CONCAT(EH_MEM, _extract)(&eh->_mem);
+    } else {
+        return false;
+    }
+
+    eh->_used--;
+
+    return true;
+}
+
+
+EH_FUNC size_t NAME_(_size)(EH_TYPE* eh) {
+    return eh->_used;
+}
+
+
+EH_FUNC size_t NAME_(_runs)(EH_TYPE* eh) {
+    return HR_CONCAT(EH_MERGE, _size)(&eh->_merge);
+}
+
+
+// How many elements have been written to disk in all, counting every time
+// merging rewrites them.
+EH_FUNC size_t NAME_(_written)(EH_TYPE* eh) {
+    return eh->_written;
+}
+
+
+// Whether reading or writing a run has ever failed. A failed write loses
+// nothing, but elements in a run which couldn't be read back are gone.
+EH_FUNC bool NAME_(_failed)(EH_TYPE* eh) {
+    return eh->_failed;
+}
+
+#endif
+
+
+#undef EH_ELEM_TYPE
+#undef EH_NAME
+#undef EH_CMP
+#undef EH_TYPE
+#undef EH_SCOPE
+#undef EH_FUNC
+#undef EH_BLOCK_BYTES
+#undef EH_TMPFILE
+#undef EH_MEM
+#undef EH_MERGE
+#undef EH_RUN
+#undef EH_BLOCK
+#undef NAME_
@@ -54,6 +54,28 @@ precedes the other in the heap ordering. For example, one potential definition \
     #define HP_CMP(x, y) ((x) < (y)) // For purposes of testing.
 #endif
 
+#if defined(HP_POOL) && HP_STORAGE != HR_STORAGE_OWNED_INDIRECT
+    #error Error: Generic binary heap only supports HP_POOL with owned indirect \
+storage.
+#endif
+
+#if defined(HP_POOL) && (defined(HP_MALLOC_ELEM) || defined(HP_FREE_ELEM))
+    #error Error: Generic binary heap is given HP_POOL along with a custom \
+HP_MALLOC_ELEM or HP_FREE_ELEM. The pool allocates the elements itself, so \
+please define one or the other.
+#endif
+
+// With HP_POOL, elements come from the heap's own pool. Every use of these is
+// in a function with the heap at hand as `hp`.
+#if defined(HP_POOL)
+    #define HP_MALLOC_ELEM (NAME_(_pool_alloc)(hp))
+    #define HP_FREE_ELEM(ptr) (NAME_(_pool_free)(hp, (ptr)))
+
+    #if !defined(HP_POOL_CHUNK)
+        #define HP_POOL_CHUNK 256
+    #endif
+#endif
+
 #if HP_STORAGE == HR_STORAGE_OWNED_INDIRECT && (!defined(HP_MALLOC_ELEM) || !defined(HP_FREE_ELEM))
     #if defined(HP_MALLOC_ELEM)
         #error Error: Generic binary heap is given a custom HP_MALLOC_ELEM, but \
@@ -101,39 +123,287 @@ HP_MALLOC_ELEM.
 
 #define NAME_(n) HR_CONCAT(HP_NAME, n)
 
+#if !defined(HP_ARITY)
+    #define HP_ARITY 2
+#endif
+
+#if HP_ARITY < 2
+    #error Error: Generic binary heap requires HP_ARITY to be at least 2.
+#endif
+
+#if defined(HP_BOUNDED) && defined(HP_INDEXED)
+    #error Error: Generic binary heap can not be both HP_BOUNDED and HP_INDEXED.
+#endif
+
+#if defined(HP_INSERT_BUFFER) && HP_INSERT_BUFFER < 1
+    #error Error: Generic binary heap requires HP_INSERT_BUFFER to be at least 1.
+#endif
+
+#if defined(HP_BOUNDED) && defined(HP_AUTO_SHRINK)
+    #error Error: Generic binary heap can not be both HP_BOUNDED and \
+HP_AUTO_SHRINK, since the size of a bounded heap is its bound.
+#endif
+
+#if defined(HP_KEY_TYPE) && !defined(HP_KEY_OF)
+    #error Error: Generic binary heap is given an HP_KEY_TYPE, but no HP_KEY_OF \
+to read the key of each element.
+#endif
+
+#if defined(HP_KEY_TYPE) && (HP_STORAGE != HR_STORAGE_DIRECT || defined(HP_INDEXED))
+    #error Error: Generic binary heap only supports HP_KEY_TYPE with direct \
+storage, and not together with HP_INDEXED.
+#endif
+
+#if defined(HP_SIMD) && (HP_STORAGE != HR_STORAGE_DIRECT || defined(HP_INDEXED) || defined(HP_KEY_TYPE))
+    #error Error: Generic binary heap only supports HP_SIMD with direct \
+storage, and not together with HP_INDEXED or HP_KEY_TYPE.
+#endif
+
+#if defined(HP_SIMD) && HP_SIMD != HR_SIMD_INT32 && HP_SIMD != HR_SIMD_INT64 && HP_SIMD != HR_SIMD_FLOAT
+    #error Error: Generic binary heap requires HP_SIMD to be one of \
+HR_SIMD_INT32, HR_SIMD_INT64 or HR_SIMD_FLOAT.
+#endif
+
+#if defined(HP_SIMD) && HP_ARITY % (HP_SIMD == HR_SIMD_INT64 ? 2 : 4) != 0
+    #error Error: Generic binary heap requires HP_ARITY to be a multiple of \
+the number of keys in a 128-bit vector (4, or 2 for HR_SIMD_INT64) when \
+HP_SIMD is defined.
+#endif
+
+#if defined(HP_SIMD) && HP_ARITY > 64
+    #error Error: Generic binary heap supports an HP_ARITY of at most 64 when \
+HP_SIMD is defined.
+#endif
+
+#define HP_PARENT(loc) (((loc) - 1) / HP_ARITY)
+#define HP_CHILD(loc) (HP_ARITY * (loc) + 1)
+
+// What the heap's array holds: the elements themselves with direct storage,
+// and pointers to them otherwise. Indexed heaps pair each with its handle.
+// With HP_KEY_TYPE, it holds just the keys, each with the index of its
+// element in a separate payload array which sifting never touches.
+#if defined(HP_INDEXED)
+    #define HP_SLOT NAME_(_slot_t)
+    #define HP_SLOT_ELEM(slot) ((slot).elem)
+#elif defined(HP_KEY_TYPE)
+    #define HP_SLOT NAME_(_slot_t)
+    #define HP_SLOT_ELEM(slot) (hp->_payload[(slot).idx])
+#elif HP_STORAGE == HR_STORAGE_DIRECT
+    #define HP_SLOT HP_ELEM_TYPE
+    #define HP_SLOT_ELEM(slot) (slot)
+#else
+    #define HP_SLOT HP_ELEM_TYPE*
+    #define HP_SLOT_ELEM(slot) (slot)
+#endif
+
+#if defined(HP_KEY_TYPE)
+    #define HP_SLOT_CMP(x, y) HP_CMP((x).key, (y).key)
+#else
+    #define HP_SLOT_CMP(x, y) HP_CMP(HP_SLOT_ELEM(x), HP_SLOT_ELEM(y))
+#endif
+
+// With HP_INSERT_BUFFER, the last _buffered slots aren't kept in heap order,
+// and anything which looks at that order merges them in first.
+#if defined(HP_INSERT_BUFFER)
+    #define HP_FLUSH(hp) NAME_(_flush)(hp)
+#else
+    #define HP_FLUSH(hp) ((void)0)
+#endif
+
+// What HP_CMP compares, and so what _extract_until takes its threshold as: a
+// key with HP_KEY_TYPE, and whatever's in the heap's slots otherwise.
+#if defined(HP_KEY_TYPE)
+    #define HP_BOUND HP_KEY_TYPE
+    #define HP_SLOT_PRECEDES(x, bound) HP_CMP((x).key, bound)
+#elif HP_STORAGE == HR_STORAGE_DIRECT
+    #define HP_BOUND HP_ELEM_TYPE
+    #define HP_SLOT_PRECEDES(x, bound) HP_CMP(HP_SLOT_ELEM(x), bound)
+#else
+    #define HP_BOUND HP_ELEM_TYPE*
+    #define HP_SLOT_PRECEDES(x, bound) HP_CMP(HP_SLOT_ELEM(x), bound)
+#endif
+
+#if HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM)
+    #define HP_MOVE_ELEM(dst, src) HP_MEMCPY_ELEM((&(dst)), (&(src)))
+#else
+    #define HP_MOVE_ELEM(dst, src) ((dst) = (src))
+#endif
+
+// Every slot which lands in the array goes through HP_PLACE, so that an
+// indexed heap can keep track of where each handle's element is.
+#if defined(HP_INDEXED)
+    #define HP_MOVE(dst, src) do { HP_MOVE_ELEM((dst).elem, (src).elem); (dst).handle = (src).handle; } while (0)
+    #define HP_PLACE(hp, loc, x) do { HP_MOVE((hp)->_data[loc], x); (hp)->_pos[(hp)->_data[loc].handle] = (loc); } while (0)
+    #define HP_NO_HANDLE SIZE_MAX
+#elif defined(HP_KEY_TYPE)
+    #define HP_MOVE(dst, src) ((dst) = (src))
+    #define HP_PLACE(hp, loc, x) HP_MOVE((hp)->_data[loc], x)
+#else
+    #define HP_MOVE(dst, src) HP_MOVE_ELEM(dst, src)
+    #define HP_PLACE(hp, loc, x) HP_MOVE((hp)->_data[loc], x)
+#endif
+
 
 typedef struct HP_TYPE HP_TYPE;
 
+#if defined(HP_INDEXED)
+typedef struct {
+#if HP_STORAGE == HR_STORAGE_DIRECT
+    HP_ELEM_TYPE elem;
+#else
+    HP_ELEM_TYPE* elem;
+#endif
+    size_t handle;
+} HP_SLOT;
+#elif defined(HP_KEY_TYPE)
+typedef struct {
+    HP_KEY_TYPE key;
+    uint32_t idx;
+} HP_SLOT;
+#endif
+
+#if defined(HP_POOL)
+#define HP_BLOCK NAME_(_block_t)
+#define HP_CHUNK NAME_(_chunk_t)
+
+// Elements are carved out of chunks of HP_POOL_CHUNK at a time. Freed elements
+// go on a free list, most recently freed first, so the next insertion reuses
+// whichever is likeliest to still be in cache, and chunks are only given back
+// at _cleanup.
+typedef union HP_BLOCK {
+    HP_ELEM_TYPE elem;
+    union HP_BLOCK* next;
+} HP_BLOCK;
+
+typedef struct HP_CHUNK {
+    struct HP_CHUNK* next;
+    HP_BLOCK blocks[HP_POOL_CHUNK];
+} HP_CHUNK;
+#endif
 
 HP_FUNC bool NAME_(_init)(HP_TYPE* hp, size_t _size);
 HP_FUNC void NAME_(_cleanup)(HP_TYPE* hp);
 HP_FUNC bool NAME_(_conditional_resize)(HP_TYPE* hp, size_t req);
+#if !defined(HP_BOUNDED)
+HP_FUNC bool NAME_(_reserve)(HP_TYPE* hp, size_t n);
+HP_FUNC bool NAME_(_shrink_to_fit)(HP_TYPE* hp);
+#endif
 
-#if HP_STORAGE == HR_STORAGE_DIRECT
-HP_FUNC bool NAME_(_insert)(HP_TYPE* hp, HP_ELEM_TYPE elem);
+#if defined(HP_INDEXED)
+    #define HP_HANDLE_PARAM , size_t* handle
+#else
+    #define HP_HANDLE_PARAM
+#endif
+
+#if HP_STORAGE == HR_STORAGE_DIRECT && !defined(HP_MEMCPY_ELEM)
+HP_FUNC bool NAME_(_insert)(HP_TYPE* hp, HP_ELEM_TYPE elem HP_HANDLE_PARAM);
+HP_FUNC HP_ELEM_TYPE NAME_(_extract)(HP_TYPE* hp);
+HP_FUNC HP_ELEM_TYPE* NAME_(_peek)(HP_TYPE* hp);
+#elif HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM)
+HP_FUNC bool NAME_(_insert)(HP_TYPE* hp, HP_ELEM_TYPE* elem HP_HANDLE_PARAM);
 HP_FUNC HP_ELEM_TYPE NAME_(_extract)(HP_TYPE* hp);
 HP_FUNC HP_ELEM_TYPE* NAME_(_peek)(HP_TYPE* hp);
 #elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
-HP_FUNC bool NAME_(_insert)(HP_TYPE* hp, HP_ELEM_TYPE* elem);
+HP_FUNC bool NAME_(_insert)(HP_TYPE* hp, HP_ELEM_TYPE* elem HP_HANDLE_PARAM);
 HP_FUNC void NAME_(_extract)(HP_TYPE* hp, HP_ELEM_TYPE* dst);
 HP_FUNC HP_ELEM_TYPE* NAME_(_peek)(HP_TYPE* hp);
 #elif HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
-HP_FUNC bool NAME_(_insert)(HP_TYPE* hp, HP_ELEM_TYPE* elem);
+HP_FUNC bool NAME_(_insert)(HP_TYPE* hp, HP_ELEM_TYPE* elem HP_HANDLE_PARAM);
 HP_FUNC HP_ELEM_TYPE* NAME_(_extract)(HP_TYPE* hp);
 HP_FUNC HP_ELEM_TYPE* NAME_(_peek)(HP_TYPE* hp);
 #endif
 
+#if HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+HP_FUNC size_t NAME_(_drain_sorted)(HP_TYPE* hp, HP_ELEM_TYPE** out);
+HP_FUNC size_t NAME_(_extract_many)(HP_TYPE* hp, HP_ELEM_TYPE** out, size_t max);
+HP_FUNC size_t NAME_(_extract_until)(HP_TYPE* hp, HP_BOUND threshold, HP_ELEM_TYPE** out, size_t max);
+#elif HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM) && !defined(HP_KEY_TYPE)
+HP_FUNC size_t NAME_(_drain_sorted)(HP_TYPE* hp, HP_ELEM_TYPE* out);
+HP_FUNC size_t NAME_(_extract_many)(HP_TYPE* hp, HP_ELEM_TYPE* out, size_t max);
+HP_FUNC size_t NAME_(_extract_until)(HP_TYPE* hp, const HP_BOUND* threshold, HP_ELEM_TYPE* out, size_t max);
+#else
+HP_FUNC size_t NAME_(_drain_sorted)(HP_TYPE* hp, HP_ELEM_TYPE* out);
+HP_FUNC size_t NAME_(_extract_many)(HP_TYPE* hp, HP_ELEM_TYPE* out, size_t max);
+HP_FUNC size_t NAME_(_extract_until)(HP_TYPE* hp, HP_BOUND threshold, HP_ELEM_TYPE* out, size_t max);
+#endif
+
+#if !defined(HP_INDEXED)
+#if HP_STORAGE == HR_STORAGE_DIRECT && !defined(HP_MEMCPY_ELEM)
+HP_FUNC HP_ELEM_TYPE NAME_(_replace)(HP_TYPE* hp, HP_ELEM_TYPE elem);
+HP_FUNC HP_ELEM_TYPE NAME_(_pushpop)(HP_TYPE* hp, HP_ELEM_TYPE elem);
+#elif HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM)
+HP_FUNC HP_ELEM_TYPE NAME_(_replace)(HP_TYPE* hp, HP_ELEM_TYPE* elem);
+HP_FUNC HP_ELEM_TYPE NAME_(_pushpop)(HP_TYPE* hp, HP_ELEM_TYPE* elem);
+#elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+HP_FUNC void NAME_(_replace)(HP_TYPE* hp, HP_ELEM_TYPE* elem, HP_ELEM_TYPE* dst);
+HP_FUNC void NAME_(_pushpop)(HP_TYPE* hp, HP_ELEM_TYPE* elem, HP_ELEM_TYPE* dst);
+#elif HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+HP_FUNC HP_ELEM_TYPE* NAME_(_replace)(HP_TYPE* hp, HP_ELEM_TYPE* elem);
+HP_FUNC HP_ELEM_TYPE* NAME_(_pushpop)(HP_TYPE* hp, HP_ELEM_TYPE* elem);
+#endif
+#endif
+
+#if defined(HP_INDEXED)
+HP_FUNC HP_ELEM_TYPE* NAME_(_get)(HP_TYPE* hp, size_t handle);
+HP_FUNC void NAME_(_decrease_key)(HP_TYPE* hp, size_t handle);
+HP_FUNC void NAME_(_increase_key)(HP_TYPE* hp, size_t handle);
+HP_FUNC void NAME_(_remove)(HP_TYPE* hp, size_t handle);
+#else
+#if HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+HP_FUNC bool NAME_(_build)(HP_TYPE* hp, HP_ELEM_TYPE* const* elems, size_t n);
+HP_FUNC bool NAME_(_insert_many)(HP_TYPE* hp, HP_ELEM_TYPE* const* elems, size_t n);
+#else
+HP_FUNC bool NAME_(_build)(HP_TYPE* hp, const HP_ELEM_TYPE* elems, size_t n);
+HP_FUNC bool NAME_(_insert_many)(HP_TYPE* hp, const HP_ELEM_TYPE* elems, size_t n);
+#endif
+#if !defined(HP_KEY_TYPE)
+#if !defined(HP_POOL)
+HP_FUNC void NAME_(_adopt)(HP_TYPE* hp, HP_SLOT* data, size_t n, size_t size);
+#endif
+HP_FUNC void NAME_(_sort)(HP_SLOT* array, size_t n);
+HP_FUNC void NAME_(_partial_sort)(HP_SLOT* array, size_t n, size_t k);
+#endif
+#endif
+
 HP_FUNC size_t NAME_(_size)(HP_TYPE* hp);
+HP_FUNC size_t NAME_(_capacity)(HP_TYPE* hp);
 
 #if HP_SCOPE != HR_SCOPE_HEADER || HP_SCOPE != HR_SCOPE_EXTERN_INLINE
 
 struct HP_TYPE {
     size_t _used;
     size_t _size;
-#if HP_STORAGE == HR_STORAGE_DIRECT
-    HP_ELEM_TYPE* _data;
-#else
-    HP_ELEM_TYPE** _data;
+    HP_SLOT* _data;
+#if defined(HP_INDEXED)
+    // Where each handle's element sits in _data. Free handles are chained
+    // together through their entries, starting from _free_handle.
+    size_t* _pos;
+    size_t _pos_used;
+    size_t _pos_size;
+    size_t _free_handle;
+#endif
+#if defined(HP_KEY_TYPE)
+    // The elements, at the indices their keys carry. Indices below
+    // _payload_used that aren't in use are stacked up in _free_idx.
+    HP_ELEM_TYPE* _payload;
+    uint32_t* _free_idx;
+    size_t _free_used;
+    size_t _payload_used;
+#endif
+#if defined(HP_POOL)
+    HP_BLOCK* _free;
+    HP_CHUNK* _chunks;
+    size_t _chunk_used;
+#endif
+#if defined(HP_AUTO_SHRINK)
+    // The size given to _init or _reserve, below which the heap never shrinks
+    // by itself.
+    size_t _min_size;
+#endif
+#if defined(HP_INSERT_BUFFER)
+    // How many of the slots at the end are insertions not yet merged into
+    // the heap, in the order they came.
+    size_t _buffered;
 #endif
 };
 
@@ -142,10 +412,10 @@ struct HP_TYPE {
 HP_FUNC void NAME_(_dump)(HP_TYPE* hp) {
     fprintf(stderr, "Heap: { ");
     if (hp->_used > 0) {
-        HP_DEBUG_DUMP(hp->_data[0]);
+        HP_DEBUG_DUMP(HP_SLOT_ELEM(hp->_data[0]));
         for (size_t i = 1; i < hp->_used; i++) {
             fprintf(stderr, ", ");
-            HP_DEBUG_DUMP(hp->_data[i]);
+            HP_DEBUG_DUMP(HP_SLOT_ELEM(hp->_data[i]));
         }
     }
     fprintf(stderr, " }\n");
@@ -155,16 +425,52 @@ HP_FUNC void NAME_(_dump)(HP_TYPE* hp) {
 
 HP_FUNC bool NAME_(_init)(HP_TYPE* hp, size_t _size) {
     hp->_size = (_size > 0 ? _size : 1);
-#if HP_STORAGE == HR_STORAGE_DIRECT
-    hp->_data = (HP_ELEM_TYPE*)malloc(hp->_size * sizeof(HP_ELEM_TYPE));
-#else
-    hp->_data = (HP_ELEM_TYPE**)malloc(hp->_size * sizeof(HP_ELEM_TYPE*));
+#if defined(HP_AUTO_SHRINK)
+    hp->_min_size = hp->_size;
 #endif
+    hp->_data = (HP_SLOT*)malloc(hp->_size * sizeof(HP_SLOT));
 
     if (hp->_data == NULL) {
         return false;
     }
 
+#if defined(HP_INDEXED)
+    hp->_pos_size = hp->_size;
+    hp->_pos_used = 0;
+    hp->_free_handle = HP_NO_HANDLE;
+    hp->_pos = (size_t*)malloc(hp->_pos_size * sizeof(size_t));
+
+    if (hp->_pos == NULL) {
+        free(hp->_data);
+        return false;
+    }
+#endif
+
+#if defined(HP_KEY_TYPE)
+    hp->_payload = (HP_ELEM_TYPE*)malloc(hp->_size * sizeof(HP_ELEM_TYPE));
+    hp->_free_idx = (uint32_t*)malloc(hp->_size * sizeof(uint32_t));
+
+    if (hp->_payload == NULL || hp->_free_idx == NULL) {
+        free(hp->_payload);
+        free(hp->_free_idx);
+        free(hp->_data);
+        return false;
+    }
+
+    hp->_free_used = 0;
+    hp->_payload_used = 0;
+#endif
+
+#if defined(HP_POOL)
+    hp->_free = NULL;
+    hp->_chunks = NULL;
+    hp->_chunk_used = HP_POOL_CHUNK;
+#endif
+
+#if defined(HP_INSERT_BUFFER)
+    hp->_buffered = 0;
+#endif
+
     hp->_used = 0;
 
     return true;
@@ -172,150 +478,1446 @@ HP_FUNC bool NAME_(_init)(HP_TYPE* hp, size_t _size) {
 
 
 HP_FUNC void NAME_(_cleanup)(HP_TYPE* hp) {
-#if HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+#if defined(HP_POOL)
+    // The elements still in the heap go along with their chunks.
+    while (hp->_chunks != NULL) {
+        HP_CHUNK* next = hp->_chunks->next;
+        free(hp->_chunks);
+        hp->_chunks = next;
+    }
+#elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
     for (size_t i = 0; i < hp->_used; i++) {
-        HP_FREE_ELEM((hp->_data[i]));
+        HP_FREE_ELEM((HP_SLOT_ELEM(hp->_data[i])));
     }
 #endif
     free(hp->_data);
+#if defined(HP_INDEXED)
+    free(hp->_pos);
+#endif
+#if defined(HP_KEY_TYPE)
+    free(hp->_payload);
+    free(hp->_free_idx);
+#endif
 }
 
 
-HP_FUNC bool NAME_(_conditional_resize)(HP_TYPE* hp, size_t req) {
-    while (hp->_size < req) {
-        hp->_size *= 2;
+// Reallocate the heap's buffers to hold exactly `size` elements, which is no
+// fewer than it holds. On failure, the heap is left as it was.
+HP_FUNC bool NAME_(_realloc)(HP_TYPE* hp, size_t size) {
+    assert(size >= hp->_used && size > 0);
+
+#if defined(HP_KEY_TYPE)
+    if (size > (size_t)UINT32_MAX + 1) {
+        return false;
     }
 
-#if HP_STORAGE == HR_STORAGE_DIRECT
-    hp->_data = (HP_ELEM_TYPE*)realloc(hp->_data, hp->_size * sizeof(HP_ELEM_TYPE));
-#else
-    hp->_data = (HP_ELEM_TYPE**)realloc(hp->_data, hp->_size * sizeof(HP_ELEM_TYPE*));
+    // Payload slots past the new size may still be in use, so move their
+    // elements down into free slots first. There are exactly as many free
+    // slots below _used as there are elements at or above it, after which
+    // the first _used slots are all in use and none are free.
+    if (size < hp->_payload_used) {
+        size_t f = 0;
+
+        for (size_t i = 0; i < hp->_used; i++) {
+            if (hp->_data[i].idx >= hp->_used) {
+                while (hp->_free_idx[f] >= hp->_used) {
+                    f++;
+                }
+
+                uint32_t idx = hp->_free_idx[f++];
+                HP_MOVE_ELEM(hp->_payload[idx], hp->_payload[hp->_data[i].idx]);
+                hp->_data[i].idx = idx;
+            }
+        }
+
+        hp->_free_used = 0;
+        hp->_payload_used = hp->_used;
+    }
 #endif
 
-    if (hp->_data == NULL) {
+    HP_SLOT* data = (HP_SLOT*)realloc(hp->_data, size * sizeof(HP_SLOT));
+
+    if (data == NULL) {
+        return false;
+    }
+
+    hp->_data = data;
+
+#if defined(HP_KEY_TYPE)
+    // Buffers that grew before a later one failed are kept, but the heap
+    // only counts on the size they all share. A buffer that fails to shrink
+    // is simply left bigger than it needs to be.
+    bool grow = size > hp->_size;
+    HP_ELEM_TYPE* payload = (HP_ELEM_TYPE*)realloc(hp->_payload, size * sizeof(HP_ELEM_TYPE));
+
+    if (payload != NULL) {
+        hp->_payload = payload;
+    } else if (grow) {
+        return false;
+    }
+
+    uint32_t* free_idx = (uint32_t*)realloc(hp->_free_idx, size * sizeof(uint32_t));
+
+    if (free_idx != NULL) {
+        hp->_free_idx = free_idx;
+    } else if (grow) {
         return false;
     }
+#endif
+
+    hp->_size = size;
+
     return true;
 }
 
 
-#define HP_PARENT(loc) ((loc - 1) / 2)
+HP_FUNC bool NAME_(_conditional_resize)(HP_TYPE* hp, size_t req) {
+    if (hp->_size >= req) {
+        return true;
+    }
 
-#if HP_STORAGE == HR_STORAGE_DIRECT && !defined(HP_MEMCPY_ELEM)
-HP_FUNC bool NAME_(_insert)(HP_TYPE* hp, HP_ELEM_TYPE elem)
-#else
-HP_FUNC bool NAME_(_insert)(HP_TYPE* hp, HP_ELEM_TYPE* elem)
+#if defined(HP_BOUNDED)
+    // Bounded heaps never grow.
+    return false;
 #endif
-{
-    if (!NAME_(_conditional_resize)(hp, hp->_used + 1)) return false;
 
-    size_t loc = hp->_used++;
+    size_t size = hp->_size;
+    while (size < req) {
+        size *= 2;
+    }
 
-    for (; loc > 0 && HP_CMP(elem, hp->_data[HP_PARENT(loc)]); loc = HP_PARENT(loc)) {
-#if HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM)
-        HP_MEMCPY_ELEM(&hp->_data[loc], &hp->_data[HP_PARENT(loc)]);
-#else
-        hp->_data[loc] = hp->_data[HP_PARENT(loc)];
+    return NAME_(_realloc)(hp, size);
+}
+
+
+#if !defined(HP_BOUNDED)
+// Make room for at least `n` elements in all, so that inserting up to that
+// many never has to grow the heap. With HP_AUTO_SHRINK, the heap then doesn't
+// shrink by itself below `n` either, or the room would be gone by the time
+// the burst it was reserved for arrives.
+HP_FUNC bool NAME_(_reserve)(HP_TYPE* hp, size_t n) {
+    if (hp->_size < n && !NAME_(_realloc)(hp, n)) return false;
+
+#if defined(HP_AUTO_SHRINK)
+    if (hp->_min_size < n) {
+        hp->_min_size = n;
+    }
+#endif
+
+    return true;
+}
+
+
+// Give back all the room the heap isn't using. With HP_AUTO_SHRINK, this also
+// drops any reservation, so the heap may shrink by itself down to its new
+// size.
+HP_FUNC bool NAME_(_shrink_to_fit)(HP_TYPE* hp) {
+    size_t size = hp->_used > 0 ? hp->_used : 1;
+    if (hp->_size != size && !NAME_(_realloc)(hp, size)) return false;
+
+#if defined(HP_AUTO_SHRINK)
+    hp->_min_size = size;
+#endif
+
+    return true;
+}
+#endif
+
+
+#if defined(HP_AUTO_SHRINK)
+// Halve the heap once it's less than a quarter full, though never below the
+// size it started with or was reserved at. It's then half full, so it takes
+// as many insertions as it has elements to make it grow again, or half as
+// many extractions to make it shrink again, and traffic around either
+// threshold can't thrash. If the smaller buffer can't be had, the heap just
+// stays as it is.
+HP_FUNC void NAME_(_auto_shrink)(HP_TYPE* hp) {
+    if (hp->_used < hp->_size / 4 && hp->_size / 2 >= hp->_min_size) {
+        NAME_(_realloc)(hp, hp->_size / 2);
+    }
+}
 #endif
+
+
+// Sift `*x` up from the hole at `loc`, moving parents down into the hole until
+// `*x` no longer precedes the parent, then drop `*x` into place.
+HP_FUNC void NAME_(_sift_up)(HP_TYPE* hp, size_t loc, HP_SLOT* x) {
+    HP_SLOT* data = hp->_data;
+
+    while (loc > 0 && HP_SLOT_CMP((*x), (data[HP_PARENT(loc)]))) {
+        HP_PLACE(hp, loc, data[HP_PARENT(loc)]);
+        loc = HP_PARENT(loc);
     }
 
-#if (HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM))
-    HP_MEMCPY_ELEM(&hp->_data[loc], elem);
-#elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
-    hp->_data[loc] = (HP_ELEM_TYPE*)(HP_MALLOC_ELEM);
-    HP_MEMCPY_ELEM(hp->_data[loc], elem);
+    HP_PLACE(hp, loc, *x);
+}
+
+
+#if defined(HP_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+
+// With HP_SIMD, the elements are plain numbers under `<`, so picking the least
+// of a full group of children is a vector min, a horizontal min across the
+// lanes, and a compare and movemask to find the first lane holding it. Each
+// width is compiled for its own target and chosen at run time, so the heap
+// still runs on machines without it.
+#if HP_SIMD == HR_SIMD_INT32
+    #define HP_V128 __m128i
+    #define HP_V128_TARGET "sse4.1"
+    #define HP_V128_LANES 4
+    #define HP_V128_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+    #define HP_V128_MIN(x, y) _mm_min_epi32(x, y)
+    #define HP_V128_SHUFFLE(x, imm) _mm_shuffle_epi32(x, imm)
+    #define HP_V128_EQ_MASK(x, y) _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, y)))
+    #define HP_V256 __m256i
+    #define HP_V256_LANES 8
+    #define HP_V256_LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+    #define HP_V256_MIN(x, y) _mm256_min_epi32(x, y)
+    #define HP_V256_SWAP_HALVES(x) _mm256_permute2x128_si256(x, x, 1)
+    #define HP_V256_SHUFFLE(x, imm) _mm256_shuffle_epi32(x, imm)
+    #define HP_V256_EQ_MASK(x, y) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, y)))
+#elif HP_SIMD == HR_SIMD_INT64
+    // There's no 64-bit integer min below AVX-512, so it's a compare and blend.
+    #define HP_V128 __m128i
+    #define HP_V128_TARGET "sse4.2"
+    #define HP_V128_LANES 2
+    #define HP_V128_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+    #define HP_V128_MIN(x, y) _mm_blendv_epi8(x, y, _mm_cmpgt_epi64(x, y))
+    #define HP_V128_SHUFFLE(x, imm) _mm_shuffle_epi32(x, imm)
+    #define HP_V128_EQ_MASK(x, y) _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(x, y)))
+    #define HP_V256 __m256i
+    #define HP_V256_LANES 4
+    #define HP_V256_LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+    #define HP_V256_MIN(x, y) _mm256_blendv_epi8(x, y, _mm256_cmpgt_epi64(x, y))
+    #define HP_V256_SWAP_HALVES(x) _mm256_permute2x128_si256(x, x, 1)
+    #define HP_V256_SHUFFLE(x, imm) _mm256_shuffle_epi32(x, imm)
+    #define HP_V256_EQ_MASK(x, y) _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, y)))
 #else
-    hp->_data[loc] = elem;
+    #define HP_V128 __m128
+    #define HP_V128_TARGET "sse4.1"
+    #define HP_V128_LANES 4
+    #define HP_V128_LOAD(p) _mm_loadu_ps(p)
+    #define HP_V128_MIN(x, y) _mm_min_ps(x, y)
+    #define HP_V128_SHUFFLE(x, imm) _mm_shuffle_ps(x, x, imm)
+    #define HP_V128_EQ_MASK(x, y) _mm_movemask_ps(_mm_cmpeq_ps(x, y))
+    #define HP_V256 __m256
+    #define HP_V256_LANES 8
+    #define HP_V256_LOAD(p) _mm256_loadu_ps(p)
+    #define HP_V256_MIN(x, y) _mm256_min_ps(x, y)
+    #define HP_V256_SWAP_HALVES(x) _mm256_permute2f128_ps(x, x, 1)
+    #define HP_V256_SHUFFLE(x, imm) _mm256_shuffle_ps(x, x, imm)
+    #define HP_V256_EQ_MASK(x, y) _mm256_movemask_ps(_mm256_cmp_ps(x, y, _CMP_EQ_OQ))
 #endif
 
-    return true;
+#define HP_SIMD_X86
+
+
+__attribute__((target(HP_V128_TARGET)))
+HP_FUNC size_t NAME_(_min_child_v128)(const HP_ELEM_TYPE* c) {
+    HP_V128 m = HP_V128_LOAD(c);
+
+    for (size_t i = HP_V128_LANES; i < HP_ARITY; i += HP_V128_LANES) {
+        m = HP_V128_MIN(m, HP_V128_LOAD(c + i));
+    }
+
+    // Swap the 64-bit halves, then (with four lanes) neighbouring lanes.
+    m = HP_V128_MIN(m, HP_V128_SHUFFLE(m, 0x4E));
+#if HP_V128_LANES == 4
+    m = HP_V128_MIN(m, HP_V128_SHUFFLE(m, 0xB1));
+#endif
+
+    // Gathering every lane's mask before looking for the first set bit keeps
+    // an unpredictable branch out of the loop.
+    unsigned long long mask = 0;
+    for (size_t i = 0; i < HP_ARITY; i += HP_V128_LANES) {
+        mask |= (unsigned long long)HP_V128_EQ_MASK(m, HP_V128_LOAD(c + i)) << i;
+    }
+
+    return __builtin_ctzll(mask);
 }
 
 
-#define HP_LEFT(loc) (2*(loc) + 1)
-#define HP_RIGHT(loc) (2*(loc) + 2)
+#if HP_ARITY % HP_V256_LANES == 0
+__attribute__((target("avx2")))
+HP_FUNC size_t NAME_(_min_child_v256)(const HP_ELEM_TYPE* c) {
+    HP_V256 m = HP_V256_LOAD(c);
 
-#if HP_STORAGE == HR_STORAGE_DIRECT
-HP_FUNC HP_ELEM_TYPE NAME_(_extract)(HP_TYPE* hp)
-#elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
-HP_FUNC void NAME_(_extract)(HP_TYPE* hp, HP_ELEM_TYPE* dst)
-#elif HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
-HP_FUNC HP_ELEM_TYPE* NAME_(_extract)(HP_TYPE* hp)
+    for (size_t i = HP_V256_LANES; i < HP_ARITY; i += HP_V256_LANES) {
+        m = HP_V256_MIN(m, HP_V256_LOAD(c + i));
+    }
+
+    m = HP_V256_MIN(m, HP_V256_SWAP_HALVES(m));
+    m = HP_V256_MIN(m, HP_V256_SHUFFLE(m, 0x4E));
+#if HP_V256_LANES == 8
+    m = HP_V256_MIN(m, HP_V256_SHUFFLE(m, 0xB1));
 #endif
-{
-    assert(hp->_used > 0);
 
-#if HP_STORAGE == HR_STORAGE_DIRECT
-    HP_ELEM_TYPE root = hp->_data[0];
-#elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
-    HP_MEMCPY_ELEM((dst), (hp->_data[0]));
-    HP_FREE_ELEM((hp->_data[0]));
-#elif HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
-    HP_ELEM_TYPE* root = hp->_data[0];
+    unsigned long long mask = 0;
+    for (size_t i = 0; i < HP_ARITY; i += HP_V256_LANES) {
+        mask |= (unsigned long long)HP_V256_EQ_MASK(m, HP_V256_LOAD(c + i)) << i;
+    }
+
+    return __builtin_ctzll(mask);
+}
 #endif
 
-#if HP_STORAGE == HR_STORAGE_DIRECT && !defined(HP_MEMCPY_ELEM)
-    HP_ELEM_TYPE tmp = hp->_data[0] = hp->_data[--hp->_used];
-#elif HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM)
-    HP_ELEM_TYPE tmp;
-    --hp->_used;
-    HP_MEMCPY_ELEM((&tmp), (hp->_data[hp->_used]));
-    HP_MEMCPY_ELEM((&hp->_data[0]), (hp->_data[hp->_used]));
-#else
-    HP_ELEM_TYPE* tmp = hp->_data[0] = hp->_data[--hp->_used];
+
+// The offset of the first least of the HP_ARITY children starting at `c`,
+// which is the same child the scalar loop in _sift_down would pick.
+HP_FUNC size_t NAME_(_min_child)(const HP_ELEM_TYPE* c) {
+#if HP_ARITY % HP_V256_LANES == 0
+    if (__builtin_cpu_supports("avx2")) {
+        return NAME_(_min_child_v256)(c);
+    }
+#endif
+
+    if (__builtin_cpu_supports(HP_V128_TARGET)) {
+        return NAME_(_min_child_v128)(c);
+    }
+
+    size_t best = 0;
+    for (size_t i = 1; i < HP_ARITY; i++) {
+        if (HP_CMP((c[i]), (c[best]))) {
+            best = i;
+        }
+    }
+
+    return best;
+}
 #endif
 
-    size_t new = 0, old = 0;
+
+// Sift `*x` down from the hole at `loc`. At each level, the first of the
+// hole's HP_ARITY children in heap order moves up if it precedes `*x`. `x` may
+// point just past the end of the heap, which is where _extract keeps the
+// element it's reinserting.
+HP_FUNC void NAME_(_sift_down)(HP_TYPE* hp, size_t loc, HP_SLOT* x) {
+    HP_SLOT* data = hp->_data;
+    size_t used = hp->_used;
+
     for (;;) {
-        old = new;
+        size_t child = HP_CHILD(loc), best = child, end = child + HP_ARITY;
 
-        if (HP_LEFT(old) < hp->_used && HP_CMP(hp->_data[HP_LEFT(old)], hp->_data[new])) {
-            new = HP_LEFT(old);
+        if (child >= used) {
+            break;
         }
 
-        if (HP_RIGHT(old) < hp->_used && HP_CMP(hp->_data[HP_RIGHT(old)], hp->_data[new])) {
-            new = HP_RIGHT(old);
+        if (end > used) {
+            end = used;
         }
 
-        if (old == new) {
-#if HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM)
-            HP_MEMCPY_ELEM((&hp->_data[new]), (&tmp));
-#else
-            hp->_data[new] = tmp;
+#if defined(HP_SIMD_X86)
+        if (end - child == HP_ARITY) {
+            best = child + NAME_(_min_child)(&data[child]);
+        } else
 #endif
+        for (child += 1; child < end; child++) {
+            if (HP_SLOT_CMP((data[child]), (data[best]))) {
+                best = child;
+            }
+        }
+
+        if (!HP_SLOT_CMP((data[best]), (*x))) {
             break;
         }
 
-#if HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM)
-        HP_MEMCPY_ELEM((&tmp), (&hp->_data[old]));
-        HP_MEMCPY_ELEM((&hp->_data[old]), (&hp->_data[new]));
-        HP_MEMCPY_ELEM((&hp->_data[new]), (&tmp));
-#else
-        tmp = hp->_data[old];
-        hp->_data[old] = hp->_data[new];
-        hp->_data[new] = tmp;
-#endif
+        HP_PLACE(hp, loc, data[best]);
+        loc = best;
     }
 
-#if HP_STORAGE != HR_STORAGE_OWNED_INDIRECT
-    return root;
+    HP_PLACE(hp, loc, *x);
+}
+
+
+#if defined(HP_BOTTOM_UP)
+// Floyd's bottom-up variant of _sift_down, for when `*x` came from the bottom
+// of the heap and will most likely end up back there. The hole goes all the
+// way down to a leaf along the path of best children, without comparing
+// against `*x`, and then `*x` is sifted back up from that leaf, though never
+// above `loc`. That takes HP_ARITY - 1 comparisons per level on the way down
+// plus the few on the way back up, rather than HP_ARITY per level.
+HP_FUNC void NAME_(_sift_down_bottom_up)(HP_TYPE* hp, size_t loc, HP_SLOT* x) {
+    HP_SLOT* data = hp->_data;
+    size_t used = hp->_used;
+    size_t top = loc;
+
+    for (;;) {
+        size_t child = HP_CHILD(loc), best = child, end = child + HP_ARITY;
+
+        if (child >= used) {
+            break;
+        }
+
+        if (end > used) {
+            end = used;
+        }
+
+#if defined(__GNUC__)
+        // The hole always goes all the way down, so the grandchildren are
+        // certain to be needed; fetch them while we pick among the children
+        // rather than stalling on them at the next level.
+        if (HP_CHILD(child) < used) {
+            __builtin_prefetch(&data[HP_CHILD(child)]);
+            __builtin_prefetch(&data[HP_CHILD(end - 1) + HP_ARITY - 1]);
+        }
+#endif
+
+#if defined(HP_SIMD_X86)
+        if (end - child == HP_ARITY) {
+            best = child + NAME_(_min_child)(&data[child]);
+        } else
 #endif
+        for (child += 1; child < end; child++) {
+            if (HP_SLOT_CMP((data[child]), (data[best]))) {
+                best = child;
+            }
+        }
+
+        HP_PLACE(hp, loc, data[best]);
+        loc = best;
+    }
+
+    while (loc > top && HP_SLOT_CMP((*x), (data[HP_PARENT(loc)]))) {
+        HP_PLACE(hp, loc, data[HP_PARENT(loc)]);
+        loc = HP_PARENT(loc);
+    }
+
+    HP_PLACE(hp, loc, *x);
 }
+#endif
 
 
-HP_FUNC HP_ELEM_TYPE* NAME_(_peek)(HP_TYPE* hp) {
-    assert(hp->_used > 0);
-    #if HP_STORAGE == HR_STORAGE_DIRECT
-    return hp->_data;
-    #else
-    return hp->_data[0];
-    #endif
+// Restore the heap property when everything from `first` onward is in no
+// particular order. Only the ancestors of the unordered elements are sifted,
+// level by level from the bottom up, so with `first` at zero this is Floyd's
+// O(n) heapify. For a batch appended to a large heap, the ancestors h levels
+// up number about batch / 2^h + 1, and each sifts down up to h levels, so it
+// costs O(batch + log^2 n).
+HP_FUNC void NAME_(_heapify)(HP_TYPE* hp, size_t first) {
+    if (hp->_used < 2 || first >= hp->_used) {
+        return;
+    }
+
+    size_t lo = first, hi = hp->_used - 1;
+
+    while (hi > 0) {
+        lo = lo > 0 ? HP_PARENT(lo) : 0;
+        hi = HP_PARENT(hi);
+
+        for (size_t i = hi + 1; i-- > lo;) {
+            HP_SLOT tmp;
+            HP_MOVE(tmp, hp->_data[i]);
+            NAME_(_sift_down)(hp, i, &tmp);
+        }
+
+        if (lo == 0) {
+            break;
+        }
+    }
+}
+
+
+#if defined(HP_INSERT_BUFFER)
+// Merge the buffered insertions into the heap. Like _insert_many, a buffer
+// that's small next to the heap is sifted up one element at a time, and
+// anything bigger is heapified in one go.
+HP_FUNC void NAME_(_flush)(HP_TYPE* hp) {
+    size_t n = hp->_buffered, first = hp->_used - n;
+
+    if (n == 0) {
+        return;
+    }
+
+    hp->_buffered = 0;
+
+    if (n * HP_ARITY >= first) {
+        NAME_(_heapify)(hp, first);
+        return;
+    }
+
+    for (size_t i = first; i < hp->_used; i++) {
+        HP_SLOT tmp;
+        HP_MOVE(tmp, hp->_data[i]);
+        NAME_(_sift_up)(hp, i, &tmp);
+    }
+}
+#endif
+
+
+#if defined(HP_INDEXED)
+// Hand out a handle, reusing a released one if there is one.
+HP_FUNC bool NAME_(_acquire_handle)(HP_TYPE* hp, size_t* handle) {
+    if (hp->_free_handle != HP_NO_HANDLE) {
+        *handle = hp->_free_handle;
+        hp->_free_handle = hp->_pos[*handle];
+        return true;
+    }
+
+    if (hp->_pos_used == hp->_pos_size) {
+        size_t* pos = (size_t*)realloc(hp->_pos, 2 * hp->_pos_size * sizeof(size_t));
+
+        if (pos == NULL) {
+            return false;
+        }
+
+        hp->_pos = pos;
+        hp->_pos_size *= 2;
+    }
+
+    *handle = hp->_pos_used++;
+
+    return true;
+}
+
+
+HP_FUNC void NAME_(_release_handle)(HP_TYPE* hp, size_t handle) {
+    hp->_pos[handle] = hp->_free_handle;
+    hp->_free_handle = handle;
+}
+#endif
+
+
+#if defined(HP_KEY_TYPE)
+// Find a payload index for a new element. There's always one to be had, as
+// long as the heap has room for the element.
+HP_FUNC uint32_t NAME_(_acquire_idx)(HP_TYPE* hp) {
+    if (hp->_free_used > 0) {
+        return hp->_free_idx[--hp->_free_used];
+    }
+
+    return (uint32_t)hp->_payload_used++;
+}
+
+
+HP_FUNC void NAME_(_release_idx)(HP_TYPE* hp, uint32_t idx) {
+    hp->_free_idx[hp->_free_used++] = idx;
+}
+#endif
+
+
+#if defined(HP_POOL)
+HP_FUNC HP_ELEM_TYPE* NAME_(_pool_alloc)(HP_TYPE* hp) {
+    HP_BLOCK* block = hp->_free;
+
+    if (block != NULL) {
+        hp->_free = block->next;
+        return &block->elem;
+    }
+
+    if (hp->_chunk_used == HP_POOL_CHUNK) {
+        HP_CHUNK* chunk = (HP_CHUNK*)malloc(sizeof(HP_CHUNK));
+
+        if (chunk == NULL) {
+            return NULL;
+        }
+
+        chunk->next = hp->_chunks;
+        hp->_chunks = chunk;
+        hp->_chunk_used = 0;
+    }
+
+    return &hp->_chunks->blocks[hp->_chunk_used++].elem;
+}
+
+
+HP_FUNC void NAME_(_pool_free)(HP_TYPE* hp, HP_ELEM_TYPE* elem) {
+    HP_BLOCK* block = (HP_BLOCK*)elem;
+    block->next = hp->_free;
+    hp->_free = block;
+}
+#endif
+
+
+#if HP_STORAGE == HR_STORAGE_DIRECT && !defined(HP_MEMCPY_ELEM)
+HP_FUNC bool NAME_(_insert)(HP_TYPE* hp, HP_ELEM_TYPE elem HP_HANDLE_PARAM)
+#else
+HP_FUNC bool NAME_(_insert)(HP_TYPE* hp, HP_ELEM_TYPE* elem HP_HANDLE_PARAM)
+#endif
+{
+#if defined(HP_BOUNDED)
+    // Once a bounded heap is full, an element only gets in if the root
+    // precedes it, and then it takes the root's place, memory and all. Nothing
+    // is allocated, so from here on, false only means it was turned away.
+    if (hp->_used == hp->_size) {
+        HP_FLUSH(hp);
+
+    #if defined(HP_KEY_TYPE) && defined(HP_MEMCPY_ELEM)
+        if (!HP_CMP((hp->_data[0].key), (HP_KEY_OF(*elem)))) return false;
+    #elif defined(HP_KEY_TYPE)
+        if (!HP_CMP((hp->_data[0].key), (HP_KEY_OF(elem)))) return false;
+    #elif HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM)
+        if (!HP_CMP((hp->_data[0]), (*elem))) return false;
+    #else
+        if (!HP_CMP((hp->_data[0]), (elem))) return false;
+    #endif
+
+        HP_SLOT slot;
+
+    #if defined(HP_KEY_TYPE)
+        // The new element takes over the root's payload index.
+        slot = hp->_data[0];
+        #if defined(HP_MEMCPY_ELEM)
+        HP_MOVE_ELEM(HP_SLOT_ELEM(slot), *elem);
+        #else
+        HP_SLOT_ELEM(slot) = elem;
+        #endif
+        slot.key = HP_KEY_OF(HP_SLOT_ELEM(slot));
+    #elif HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM)
+        HP_MOVE_ELEM(slot, *elem);
+    #elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+        slot = hp->_data[0];
+        HP_MEMCPY_ELEM(slot, elem);
+    #else
+        slot = elem;
+    #endif
+
+        NAME_(_sift_down)(hp, 0, &slot);
+
+        return true;
+    }
+#endif
+
+    if (!NAME_(_conditional_resize)(hp, hp->_used + 1)) return false;
+
+    HP_SLOT slot;
+
+#if defined(HP_KEY_TYPE)
+    slot.idx = NAME_(_acquire_idx)(hp);
+#endif
+
+#if HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM)
+    HP_MOVE_ELEM(HP_SLOT_ELEM(slot), *elem);
+#elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    HP_SLOT_ELEM(slot) = (HP_ELEM_TYPE*)(HP_MALLOC_ELEM);
+
+    if (HP_SLOT_ELEM(slot) == NULL) {
+        return false;
+    }
+
+    HP_MEMCPY_ELEM(HP_SLOT_ELEM(slot), elem);
+#else
+    HP_SLOT_ELEM(slot) = elem;
+#endif
+
+#if defined(HP_KEY_TYPE)
+    slot.key = HP_KEY_OF(HP_SLOT_ELEM(slot));
+#endif
+
+#if defined(HP_INDEXED)
+    if (!NAME_(_acquire_handle)(hp, &slot.handle)) {
+#if HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+        HP_FREE_ELEM((slot.elem));
+#endif
+        return false;
+    }
+
+    if (handle != NULL) {
+        *handle = slot.handle;
+    }
+#endif
+
+#if defined(HP_INSERT_BUFFER)
+    // Just append it, and leave the sifting for later.
+    HP_PLACE(hp, hp->_used, slot);
+    hp->_used += 1;
+
+    if (++hp->_buffered == HP_INSERT_BUFFER) {
+        NAME_(_flush)(hp);
+    }
+#else
+    NAME_(_sift_up)(hp, hp->_used, &slot);
+
+    hp->_used += 1;
+#endif
+
+    return true;
+}
+
+
+#if HP_STORAGE == HR_STORAGE_DIRECT
+HP_FUNC HP_ELEM_TYPE NAME_(_extract)(HP_TYPE* hp)
+#elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+HP_FUNC void NAME_(_extract)(HP_TYPE* hp, HP_ELEM_TYPE* dst)
+#elif HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+HP_FUNC HP_ELEM_TYPE* NAME_(_extract)(HP_TYPE* hp)
+#endif
+{
+    assert(hp->_used > 0);
+
+    HP_FLUSH(hp);
+
+#if HP_STORAGE == HR_STORAGE_DIRECT
+    HP_ELEM_TYPE root;
+    HP_MOVE_ELEM(root, HP_SLOT_ELEM(hp->_data[0]));
+#elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    HP_MEMCPY_ELEM((dst), (HP_SLOT_ELEM(hp->_data[0])));
+    HP_FREE_ELEM((HP_SLOT_ELEM(hp->_data[0])));
+#elif HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+    HP_ELEM_TYPE* root = HP_SLOT_ELEM(hp->_data[0]);
+#endif
+
+#if defined(HP_INDEXED)
+    NAME_(_release_handle)(hp, hp->_data[0].handle);
+#elif defined(HP_KEY_TYPE)
+    NAME_(_release_idx)(hp, hp->_data[0].idx);
+#endif
+
+    // The last element fills the hole left at the root.
+    if (--hp->_used > 0) {
+#if defined(HP_BOTTOM_UP)
+        NAME_(_sift_down_bottom_up)(hp, 0, &hp->_data[hp->_used]);
+#else
+        NAME_(_sift_down)(hp, 0, &hp->_data[hp->_used]);
+#endif
+    }
+
+#if defined(HP_AUTO_SHRINK)
+    NAME_(_auto_shrink)(hp);
+#endif
+
+#if HP_STORAGE != HR_STORAGE_OWNED_INDIRECT
+    return root;
+#endif
+}
+
+
+#if !defined(HP_INDEXED)
+// Extract the root and insert `elem` in its place, with a single sift-down.
+// With owned indirect storage, the root's element is reused for `elem`, and
+// `elem` and `dst` must not overlap.
+#if HP_STORAGE == HR_STORAGE_DIRECT && !defined(HP_MEMCPY_ELEM)
+HP_FUNC HP_ELEM_TYPE NAME_(_replace)(HP_TYPE* hp, HP_ELEM_TYPE elem)
+#elif HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM)
+HP_FUNC HP_ELEM_TYPE NAME_(_replace)(HP_TYPE* hp, HP_ELEM_TYPE* elem)
+#elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+HP_FUNC void NAME_(_replace)(HP_TYPE* hp, HP_ELEM_TYPE* elem, HP_ELEM_TYPE* dst)
+#elif HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+HP_FUNC HP_ELEM_TYPE* NAME_(_replace)(HP_TYPE* hp, HP_ELEM_TYPE* elem)
+#endif
+{
+    assert(hp->_used > 0);
+
+    HP_FLUSH(hp);
+
+    HP_SLOT slot;
+
+#if defined(HP_KEY_TYPE)
+    // Only the root's payload is swapped; its index stays put.
+    HP_ELEM_TYPE root;
+    slot = hp->_data[0];
+    HP_MOVE_ELEM(root, HP_SLOT_ELEM(slot));
+    #if defined(HP_MEMCPY_ELEM)
+    HP_MOVE_ELEM(HP_SLOT_ELEM(slot), *elem);
+    #else
+    HP_SLOT_ELEM(slot) = elem;
+    #endif
+    slot.key = HP_KEY_OF(HP_SLOT_ELEM(slot));
+#elif HP_STORAGE == HR_STORAGE_DIRECT
+    HP_ELEM_TYPE root;
+    HP_MOVE_ELEM(root, hp->_data[0]);
+    #if defined(HP_MEMCPY_ELEM)
+    HP_MOVE_ELEM(slot, *elem);
+    #else
+    slot = elem;
+    #endif
+#elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    slot = hp->_data[0];
+    HP_MEMCPY_ELEM((dst), (slot));
+    HP_MEMCPY_ELEM((slot), (elem));
+#elif HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+    HP_ELEM_TYPE* root = hp->_data[0];
+    slot = elem;
+#endif
+
+    NAME_(_sift_down)(hp, 0, &slot);
+
+#if HP_STORAGE != HR_STORAGE_OWNED_INDIRECT
+    return root;
+#endif
+}
+
+
+// Insert `elem` and extract the root, with at most a single sift-down. If the
+// heap is empty or `elem` would come out first anyway, it's handed straight
+// back without touching the heap.
+#if HP_STORAGE == HR_STORAGE_DIRECT && !defined(HP_MEMCPY_ELEM)
+HP_FUNC HP_ELEM_TYPE NAME_(_pushpop)(HP_TYPE* hp, HP_ELEM_TYPE elem)
+#elif HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM)
+HP_FUNC HP_ELEM_TYPE NAME_(_pushpop)(HP_TYPE* hp, HP_ELEM_TYPE* elem)
+#elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+HP_FUNC void NAME_(_pushpop)(HP_TYPE* hp, HP_ELEM_TYPE* elem, HP_ELEM_TYPE* dst)
+#elif HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+HP_FUNC HP_ELEM_TYPE* NAME_(_pushpop)(HP_TYPE* hp, HP_ELEM_TYPE* elem)
+#endif
+{
+    HP_FLUSH(hp);
+
+#if defined(HP_KEY_TYPE) && defined(HP_MEMCPY_ELEM)
+    if (hp->_used == 0 || !HP_CMP((hp->_data[0].key), (HP_KEY_OF(*elem)))) {
+        return *elem;
+    }
+#elif defined(HP_KEY_TYPE)
+    if (hp->_used == 0 || !HP_CMP((hp->_data[0].key), (HP_KEY_OF(elem)))) {
+        return elem;
+    }
+#elif HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM)
+    if (hp->_used == 0 || !HP_CMP((hp->_data[0]), (*elem))) {
+        return *elem;
+    }
+#elif HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    if (hp->_used == 0 || !HP_CMP((hp->_data[0]), (elem))) {
+        HP_MEMCPY_ELEM((dst), (elem));
+        return;
+    }
+#else
+    if (hp->_used == 0 || !HP_CMP((hp->_data[0]), (elem))) {
+        return elem;
+    }
+#endif
+
+#if HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    NAME_(_replace)(hp, elem, dst);
+#else
+    return NAME_(_replace)(hp, elem);
+#endif
+}
+#endif
+
+
+// Empty the heap into `out` back to front, so that `out` ends up sorted with
+// the element which would have been extracted last at the front. Returns the
+// number of elements written.
+#if HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+HP_FUNC size_t NAME_(_drain_sorted)(HP_TYPE* hp, HP_ELEM_TYPE** out)
+#else
+HP_FUNC size_t NAME_(_drain_sorted)(HP_TYPE* hp, HP_ELEM_TYPE* out)
+#endif
+{
+    size_t n = hp->_used;
+
+    for (size_t i = n; i-- > 0;) {
+#if HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+        NAME_(_extract)(hp, &out[i]);
+#else
+        out[i] = NAME_(_extract)(hp);
+#endif
+    }
+
+    return n;
+}
+
+
+// Move the slot at `loc` out of the heap into `*dst`, leaving a hole behind.
+// Its handle or payload index is released, and with owned indirect storage,
+// its element is copied out and freed.
+#if HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+HP_FUNC void NAME_(_take)(HP_TYPE* hp, size_t loc, HP_ELEM_TYPE** dst)
+#else
+HP_FUNC void NAME_(_take)(HP_TYPE* hp, size_t loc, HP_ELEM_TYPE* dst)
+#endif
+{
+#if HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    HP_MEMCPY_ELEM((dst), (HP_SLOT_ELEM(hp->_data[loc])));
+    HP_FREE_ELEM((HP_SLOT_ELEM(hp->_data[loc])));
+#else
+    HP_MOVE_ELEM(*dst, HP_SLOT_ELEM(hp->_data[loc]));
+#endif
+
+#if defined(HP_INDEXED)
+    NAME_(_release_handle)(hp, hp->_data[loc].handle);
+#elif defined(HP_KEY_TYPE)
+    NAME_(_release_idx)(hp, hp->_data[loc].idx);
+#endif
+}
+
+
+HP_FUNC int NAME_(_loc_cmp)(const void* a, const void* b) {
+    size_t x = *(const size_t*)a, y = *(const size_t*)b;
+    return (x > y) - (x < y);
+}
+
+
+// Double the room in `*locs`, which has room for `*cap` locations.
+HP_FUNC bool NAME_(_grow_locs)(size_t** locs, size_t* cap) {
+    size_t* grown = (size_t*)realloc(*locs, 2 * *cap * sizeof(size_t));
+
+    if (grown == NULL) {
+        return false;
+    }
+
+    *locs = grown;
+    *cap *= 2;
+
+    return true;
+}
+
+
+// Find the locations of every element which precedes `*bound`, walking down
+// from the root breadth-first. Whatever's above such an element precedes the
+// bound too, so this only looks at those elements and their children, and
+// finds them in increasing order of location. The root must be one of them.
+// Returns how many there are, or SIZE_MAX if there are more than `max` or
+// `*locs` can't grow to hold them.
+HP_FUNC size_t NAME_(_find_until)(HP_TYPE* hp, HP_BOUND const* bound, size_t max, size_t** locs, size_t* cap) {
+    size_t n = 1, next = 0;
+    (*locs)[0] = 0;
+
+    while (next < n) {
+        size_t loc = (*locs)[next++];
+
+        for (size_t child = HP_CHILD(loc), end = child + HP_ARITY; child < end && child < hp->_used; child++) {
+            if (!HP_SLOT_PRECEDES((hp->_data[child]), (*bound))) {
+                continue;
+            }
+
+            if (n == max || (n == *cap && !NAME_(_grow_locs)(locs, cap))) {
+                return SIZE_MAX;
+            }
+
+            (*locs)[n++] = child;
+        }
+    }
+
+    return n;
+}
+
+
+// Add `loc` to `frontier`, a binary heap of `n` locations ordered by the slots
+// they point to.
+HP_FUNC void NAME_(_frontier_push)(HP_TYPE* hp, size_t* frontier, size_t n, size_t loc) {
+    while (n > 0 && HP_SLOT_CMP((hp->_data[loc]), (hp->_data[frontier[(n - 1) / 2]]))) {
+        frontier[n] = frontier[(n - 1) / 2];
+        n = (n - 1) / 2;
+    }
+
+    frontier[n] = loc;
+}
+
+
+// Remove and return the first of the `n` locations in `frontier`.
+HP_FUNC size_t NAME_(_frontier_pop)(HP_TYPE* hp, size_t* frontier, size_t n) {
+    size_t first = frontier[0], last = frontier[--n], hole = 0;
+
+    for (;;) {
+        size_t child = 2 * hole + 1;
+
+        if (child >= n) {
+            break;
+        }
+
+        if (child + 1 < n && HP_SLOT_CMP((hp->_data[frontier[child + 1]]), (hp->_data[frontier[child]]))) {
+            child += 1;
+        }
+
+        if (!HP_SLOT_CMP((hp->_data[frontier[child]]), (hp->_data[last]))) {
+            break;
+        }
+
+        frontier[hole] = frontier[child];
+        hole = child;
+    }
+
+    frontier[hole] = last;
+
+    return first;
+}
+
+
+// Find the locations of the first `max` elements in heap order, of those which
+// precede `*bound` if it isn't NULL, in that order. This walks down from the
+// root too, but keeps the locations which could come next in a small heap of
+// their own, and always takes the first of them. Returns how many it found, or
+// SIZE_MAX if it ran out of memory.
+HP_FUNC size_t NAME_(_find_first)(HP_TYPE* hp, HP_BOUND const* bound, size_t max, size_t** locs, size_t* cap) {
+    // Each location taken adds at most HP_ARITY - 1 to the frontier.
+    size_t frontier_cap = *cap * (HP_ARITY - 1) + 1;
+    size_t* frontier = (size_t*)malloc(frontier_cap * sizeof(size_t));
+    size_t n = 0, fill = 1;
+
+    if (frontier == NULL) {
+        return SIZE_MAX;
+    }
+
+    frontier[0] = 0;
+
+    while (n < max && fill > 0) {
+        if (n == *cap) {
+            size_t* grown = (size_t*)realloc(frontier, (2 * *cap * (HP_ARITY - 1) + 1) * sizeof(size_t));
+
+            if (grown != NULL) {
+                frontier = grown;
+            }
+
+            if (grown == NULL || !NAME_(_grow_locs)(locs, cap)) {
+                n = SIZE_MAX;
+                break;
+            }
+        }
+
+        size_t loc = NAME_(_frontier_pop)(hp, frontier, fill--);
+        (*locs)[n++] = loc;
+
+        for (size_t child = HP_CHILD(loc), end = child + HP_ARITY; child < end && child < hp->_used; child++) {
+            if (bound == NULL || HP_SLOT_PRECEDES((hp->_data[child]), (*bound))) {
+                NAME_(_frontier_push)(hp, frontier, fill++, child);
+            }
+        }
+    }
+
+    free(frontier);
+
+    return n;
+}
+
+
+// Extract up to `max` elements into `out`, stopping at the first which
+// doesn't precede `*bound` if `bound` isn't NULL, and return how many there
+// were.
+//
+// The elements to go are always the root and some of its descendants, so
+// rather than extracting them one at a time, with a sift-down from the root
+// each, this finds them all first and copies them out, then refills the holes
+// they left from the end of the heap, deepest first. Everything below each
+// hole is a heap by the time it's refilled, so one sift-down from the hole
+// itself puts it right, as in Floyd's heapify. With a bound and no more than
+// `max` elements before it, they're found breadth-first and come out in no
+// particular order. Otherwise they're found in heap order, and come out in
+// that order. If there isn't memory to keep track of the holes, this falls
+// back on _extract.
+#if HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+HP_FUNC size_t NAME_(_extract_top)(HP_TYPE* hp, HP_ELEM_TYPE** out, size_t max, HP_BOUND const* bound)
+#else
+HP_FUNC size_t NAME_(_extract_top)(HP_TYPE* hp, HP_ELEM_TYPE* out, size_t max, HP_BOUND const* bound)
+#endif
+{
+    HP_FLUSH(hp);
+
+    if (max > hp->_used) {
+        max = hp->_used;
+    }
+
+    if (max == 0 || (bound != NULL && !HP_SLOT_PRECEDES((hp->_data[0]), (*bound)))) {
+        return 0;
+    }
+
+    size_t cap = 64, n = SIZE_MAX;
+    size_t* locs = (size_t*)malloc(cap * sizeof(size_t));
+
+    if (locs != NULL && bound != NULL) {
+        n = NAME_(_find_until)(hp, bound, max, &locs, &cap);
+    }
+
+    // Locations found breadth-first are already in increasing order.
+    bool by_loc = n != SIZE_MAX;
+
+    if (locs != NULL && n == SIZE_MAX) {
+        n = NAME_(_find_first)(hp, bound, max, &locs, &cap);
+    }
+
+    if (locs == NULL || n == SIZE_MAX) {
+        free(locs);
+
+        for (n = 0; n < max && hp->_used > 0; n++) {
+            if (bound != NULL && !HP_SLOT_PRECEDES((hp->_data[0]), (*bound))) {
+                break;
+            }
+#if HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+            NAME_(_extract)(hp, &out[n]);
+#else
+            out[n] = NAME_(_extract)(hp);
+#endif
+        }
+
+        return n;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        NAME_(_take)(hp, locs[i], &out[i]);
+    }
+
+    // Holes past the new end of the heap are simply dropped, and the others
+    // filled with what's left at the end, which by then is never a hole.
+    if (!by_loc) {
+        qsort(locs, n, sizeof(size_t), NAME_(_loc_cmp));
+    }
+
+    for (size_t i = n; i-- > 0;) {
+        if (locs[i] == --hp->_used) {
+            continue;
+        }
+
+#if defined(HP_BOTTOM_UP)
+        NAME_(_sift_down_bottom_up)(hp, locs[i], &hp->_data[hp->_used]);
+#else
+        NAME_(_sift_down)(hp, locs[i], &hp->_data[hp->_used]);
+#endif
+    }
+
+    free(locs);
+
+#if defined(HP_AUTO_SHRINK)
+    NAME_(_auto_shrink)(hp);
+#endif
+
+    return n;
+}
+
+
+// Extract up to `max` elements into `out`, in the order _extract would give
+// them, and return how many there were.
+#if HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+HP_FUNC size_t NAME_(_extract_many)(HP_TYPE* hp, HP_ELEM_TYPE** out, size_t max)
+#else
+HP_FUNC size_t NAME_(_extract_many)(HP_TYPE* hp, HP_ELEM_TYPE* out, size_t max)
+#endif
+{
+    return NAME_(_extract_top)(hp, out, max, NULL);
+}
+
+
+// Extract every element which precedes `threshold` into `out`, in no
+// particular order, and return how many there were. If there are more than
+// `max`, only the first `max` of them are extracted, in order.
+#if HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+HP_FUNC size_t NAME_(_extract_until)(HP_TYPE* hp, HP_BOUND threshold, HP_ELEM_TYPE** out, size_t max)
+#elif HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM) && !defined(HP_KEY_TYPE)
+HP_FUNC size_t NAME_(_extract_until)(HP_TYPE* hp, const HP_BOUND* threshold, HP_ELEM_TYPE* out, size_t max)
+#else
+HP_FUNC size_t NAME_(_extract_until)(HP_TYPE* hp, HP_BOUND threshold, HP_ELEM_TYPE* out, size_t max)
+#endif
+{
+#if HP_STORAGE == HR_STORAGE_DIRECT && defined(HP_MEMCPY_ELEM) && !defined(HP_KEY_TYPE)
+    return NAME_(_extract_top)(hp, out, max, threshold);
+#else
+    return NAME_(_extract_top)(hp, out, max, &threshold);
+#endif
+}
+
+
+#if defined(HP_INDEXED)
+HP_FUNC HP_ELEM_TYPE* NAME_(_get)(HP_TYPE* hp, size_t handle) {
+#if HP_STORAGE == HR_STORAGE_DIRECT
+    return &hp->_data[hp->_pos[handle]].elem;
+#else
+    return hp->_data[hp->_pos[handle]].elem;
+#endif
+}
+
+
+// Call after changing the element behind `handle` so that it moves toward the
+// root of the heap.
+HP_FUNC void NAME_(_decrease_key)(HP_TYPE* hp, size_t handle) {
+    size_t loc = hp->_pos[handle];
+
+#if defined(HP_INSERT_BUFFER)
+    // A buffered element gets sifted when the buffer is merged, and one in
+    // the heap proper only has to be put back in order there, since the
+    // buffer is merged against that order later.
+    if (loc >= hp->_used - hp->_buffered) return;
+#endif
+
+    HP_SLOT tmp;
+    HP_MOVE(tmp, hp->_data[loc]);
+    NAME_(_sift_up)(hp, loc, &tmp);
+}
+
+
+// Call after changing the element behind `handle` so that it moves away from
+// the root of the heap.
+HP_FUNC void NAME_(_increase_key)(HP_TYPE* hp, size_t handle) {
+    size_t loc = hp->_pos[handle];
+
+#if defined(HP_INSERT_BUFFER)
+    // As with _decrease_key, but the sift must not reach into the buffer.
+    size_t buffered = hp->_buffered;
+
+    if (loc >= hp->_used - buffered) return;
+
+    hp->_used -= buffered;
+#endif
+
+    HP_SLOT tmp;
+    HP_MOVE(tmp, hp->_data[loc]);
+    NAME_(_sift_down)(hp, loc, &tmp);
+
+#if defined(HP_INSERT_BUFFER)
+    hp->_used += buffered;
+#endif
+}
+
+
+HP_FUNC void NAME_(_remove)(HP_TYPE* hp, size_t handle) {
+    HP_FLUSH(hp);
+
+    size_t loc = hp->_pos[handle];
+
+#if HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    HP_FREE_ELEM((hp->_data[loc].elem));
+#endif
+
+    NAME_(_release_handle)(hp, handle);
+
+    // The last element fills the hole, and may have to go either way from
+    // there.
+    if (loc != --hp->_used) {
+        HP_SLOT* last = &hp->_data[hp->_used];
+
+        if (loc > 0 && HP_SLOT_CMP((*last), (hp->_data[HP_PARENT(loc)]))) {
+            NAME_(_sift_up)(hp, loc, last);
+        } else {
+            NAME_(_sift_down)(hp, loc, last);
+        }
+    }
+
+#if defined(HP_AUTO_SHRINK)
+    NAME_(_auto_shrink)(hp);
+#endif
+}
+#else
+#if HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+HP_FUNC bool NAME_(_insert_many)(HP_TYPE* hp, HP_ELEM_TYPE* const* elems, size_t n)
+#else
+HP_FUNC bool NAME_(_insert_many)(HP_TYPE* hp, const HP_ELEM_TYPE* elems, size_t n)
+#endif
+{
+#if defined(HP_BOUNDED)
+    // Bounded heaps never grow, so every element has to get past the root on
+    // its own. Until the heap is full, a failed insertion means an element
+    // couldn't be allocated; after that, it was only turned away.
+    for (size_t i = 0; i < n; i++) {
+        bool full = hp->_used == hp->_size;
+
+    #if (HP_STORAGE == HR_STORAGE_DIRECT && !defined(HP_MEMCPY_ELEM)) || HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+        if (!NAME_(_insert)(hp, elems[i]) && !full) return false;
+    #else
+        if (!NAME_(_insert)(hp, (HP_ELEM_TYPE*)&elems[i]) && !full) return false;
+    #endif
+    }
+
+    return true;
+#else
+    if (!NAME_(_conditional_resize)(hp, hp->_used + n)) return false;
+
+    HP_FLUSH(hp);
+
+    // A batch that's small next to the heap is cheapest to sift up one element
+    // at a time; anything bigger is appended and heapified in one go.
+    bool bulk = n * HP_ARITY >= hp->_used;
+    size_t first = hp->_used;
+
+    for (size_t i = 0; i < n; i++) {
+#if HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+        HP_ELEM_TYPE* elem = (HP_ELEM_TYPE*)(HP_MALLOC_ELEM);
+
+        if (elem == NULL) {
+            if (bulk) {
+                NAME_(_heapify)(hp, first);
+            }
+            return false;
+        }
+
+        HP_MEMCPY_ELEM(elem, &elems[i]);
+#elif HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+        HP_ELEM_TYPE* elem = elems[i];
+#elif defined(HP_KEY_TYPE)
+        HP_SLOT elem;
+        elem.idx = NAME_(_acquire_idx)(hp);
+        HP_MOVE_ELEM(HP_SLOT_ELEM(elem), elems[i]);
+        elem.key = HP_KEY_OF(HP_SLOT_ELEM(elem));
+#else
+        HP_SLOT elem;
+        HP_MOVE(elem, elems[i]);
+#endif
+
+        if (bulk) {
+            HP_MOVE(hp->_data[hp->_used], elem);
+        } else {
+            NAME_(_sift_up)(hp, hp->_used, &elem);
+        }
+
+        hp->_used += 1;
+    }
+
+    if (bulk) {
+        NAME_(_heapify)(hp, first);
+    }
+
+    return true;
+#endif
+}
+
+
+#if HP_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+HP_FUNC bool NAME_(_build)(HP_TYPE* hp, HP_ELEM_TYPE* const* elems, size_t n)
+#else
+HP_FUNC bool NAME_(_build)(HP_TYPE* hp, const HP_ELEM_TYPE* elems, size_t n)
+#endif
+{
+#if HP_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    for (size_t i = 0; i < hp->_used; i++) {
+        HP_FREE_ELEM((hp->_data[i]));
+    }
+#endif
+#if defined(HP_KEY_TYPE)
+    hp->_free_used = 0;
+    hp->_payload_used = 0;
+#endif
+#if defined(HP_INSERT_BUFFER)
+    hp->_buffered = 0;
+#endif
+    hp->_used = 0;
+
+    return NAME_(_insert_many)(hp, elems, n);
+}
+
+
+#if !defined(HP_KEY_TYPE)
+#if !defined(HP_POOL)
+// Take over `data`, a buffer from malloc with room for `size` slots, the first
+// `n` of which are filled, and heapify it in place. The heap's old contents are
+// released. With owned indirect storage, the elements pointed to must have come
+// from HP_MALLOC_ELEM, since the heap will free them.
+HP_FUNC void NAME_(_adopt)(HP_TYPE* hp, HP_SLOT* data, size_t n, size_t size) {
+    assert(n <= size && size > 0);
+
+    NAME_(_cleanup)(hp);
+
+    hp->_data = data;
+    hp->_used = n;
+    hp->_size = size;
+#if defined(HP_INSERT_BUFFER)
+    hp->_buffered = 0;
+#endif
+
+    NAME_(_heapify)(hp, 0);
+}
+#endif
+
+
+// Heapsort the heap in `hp` in place, moving each root to the end of what's
+// left, so that the array ends up in the order _drain_sorted would write it.
+HP_FUNC void NAME_(_sort_heap)(HP_TYPE* hp) {
+    HP_SLOT* data = hp->_data;
+
+    while (hp->_used > 1) {
+        HP_SLOT tmp;
+        HP_MOVE(tmp, data[hp->_used - 1]);
+        HP_MOVE(data[hp->_used - 1], data[0]);
+        hp->_used -= 1;
+#if defined(HP_BOTTOM_UP)
+        NAME_(_sift_down_bottom_up)(hp, 0, &tmp);
+#else
+        NAME_(_sift_down)(hp, 0, &tmp);
+#endif
+    }
+}
+
+
+// Sort the `n` slots of `array` in place with heapsort, using no memory
+// beyond the array itself, into HP_CMP order: the element a heap would
+// extract first ends up at the front. Heapsort leaves the array back to
+// front, so it's reversed at the end.
+HP_FUNC void NAME_(_sort)(HP_SLOT* array, size_t n) {
+    HP_TYPE hp = {0};
+    hp._data = array;
+    hp._used = n;
+
+    NAME_(_heapify)(&hp, 0);
+    NAME_(_sort_heap)(&hp);
+
+    for (size_t i = 0, j = n; i + 1 < j; i++, j--) {
+        HP_SLOT tmp;
+        HP_MOVE(tmp, array[i]);
+        HP_MOVE(array[i], array[j - 1]);
+        HP_MOVE(array[j - 1], tmp);
+    }
+}
+
+
+// A binary sift-down with HP_CMP turned around, so that the root is the
+// element a heap would extract last. _partial_sort keeps its best k in one.
+HP_FUNC void NAME_(_sift_down_last)(HP_SLOT* data, size_t used, size_t i, HP_SLOT* elem) {
+    for (;;) {
+        size_t child = 2 * i + 1;
+
+        if (child >= used) {
+            break;
+        }
+
+        if (child + 1 < used && HP_SLOT_CMP((data[child]), (data[child + 1]))) {
+            child++;
+        }
+
+        if (!HP_SLOT_CMP((*elem), (data[child]))) {
+            break;
+        }
+
+        HP_MOVE(data[i], data[child]);
+        i = child;
+    }
+
+    HP_MOVE(data[i], *elem);
+}
+
+
+// Move the first `k` slots of `array` in HP_CMP order, the ones a heap would
+// extract first, to the front, sorted, and leave the rest after them in no
+// particular order. The front `k` are kept as a heap of the opposite order,
+// whose root is the one to beat, while the others are checked against it,
+// so this takes O(n log k) time and no extra memory.
+HP_FUNC void NAME_(_partial_sort)(HP_SLOT* array, size_t n, size_t k) {
+    if (k > n) {
+        k = n;
+    }
+
+    if (k == 0) {
+        return;
+    }
+
+    HP_SLOT tmp;
+
+    for (size_t i = k / 2; i-- > 0;) {
+        HP_MOVE(tmp, array[i]);
+        NAME_(_sift_down_last)(array, k, i, &tmp);
+    }
+
+    for (size_t i = k; i < n; i++) {
+        if (HP_SLOT_CMP((array[i]), (array[0]))) {
+            HP_MOVE(tmp, array[i]);
+            HP_MOVE(array[i], array[0]);
+            NAME_(_sift_down_last)(array, k, 0, &tmp);
+        }
+    }
+
+    // Moving each root to the end of what's left sorts the front forwards.
+    for (size_t used = k; used > 1; used--) {
+        HP_MOVE(tmp, array[used - 1]);
+        HP_MOVE(array[used - 1], array[0]);
+        NAME_(_sift_down_last)(array, used - 1, 0, &tmp);
+    }
+}
+#endif
+#endif
+
+
+HP_FUNC HP_ELEM_TYPE* NAME_(_peek)(HP_TYPE* hp) {
+    assert(hp->_used > 0);
+    HP_FLUSH(hp);
+    #if HP_STORAGE == HR_STORAGE_DIRECT
+    return &HP_SLOT_ELEM(hp->_data[0]);
+    #else
+    return HP_SLOT_ELEM(hp->_data[0]);
+    #endif
 }
 
 HP_FUNC size_t NAME_(_size)(HP_TYPE* hp) {
     return hp->_used;
 }
 
+HP_FUNC size_t NAME_(_capacity)(HP_TYPE* hp) {
+    return hp->_size;
+}
+
 #endif
 
 
@@ -325,13 +1927,51 @@ HP_FUNC size_t NAME_(_size)(HP_TYPE* hp) {
 #undef HP_STORAGE
 #undef HP_MALLOC_ELEM
 #undef HP_FREE_ELEM
+#undef HP_POOL
+#undef HP_POOL_CHUNK
+#undef HP_BLOCK
+#undef HP_CHUNK
 #undef HP_MEMCPY_ELEM
 #undef HP_TYPE
 #undef HP_SCOPE
 #undef HP_FUNC
 #undef NAME_
 #undef HP_PARENT
-#undef HP_LEFT
-#undef HP_RIGHT
+#undef HP_CHILD
+#undef HP_ARITY
+#undef HP_SLOT
+#undef HP_SLOT_ELEM
+#undef HP_SLOT_CMP
+#undef HP_BOUND
+#undef HP_SLOT_PRECEDES
+#undef HP_MOVE
+#undef HP_MOVE_ELEM
+#undef HP_PLACE
+#undef HP_INDEXED
+#undef HP_BOUNDED
+#undef HP_AUTO_SHRINK
+#undef HP_INSERT_BUFFER
+#undef HP_FLUSH
+#undef HP_BOTTOM_UP
+#undef HP_KEY_TYPE
+#undef HP_KEY_OF
+#undef HP_SIMD
+#undef HP_SIMD_X86
+#undef HP_V128
+#undef HP_V128_TARGET
+#undef HP_V128_LANES
+#undef HP_V128_LOAD
+#undef HP_V128_MIN
+#undef HP_V128_SHUFFLE
+#undef HP_V128_EQ_MASK
+#undef HP_V256
+#undef HP_V256_LANES
+#undef HP_V256_LOAD
+#undef HP_V256_MIN
+#undef HP_V256_SWAP_HALVES
+#undef HP_V256_SHUFFLE
+#undef HP_V256_EQ_MASK
+#undef HP_NO_HANDLE
+#undef HP_HANDLE_PARAM
 #undef HP_DEBUG
 #undef HP_DEBUG_DUMP
@@ -0,0 +1,446 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "horror/macro.h"
+
+
+#if !defined(KM_ELEM_TYPE)
+    #error Error: Generic k-way merge requires KM_ELEM_TYPE to be defined.
+    #define KM_ELEM_TYPE int // For purposes of testing.
+#endif
+
+#if !defined(KM_NAME)
+    #error Error: Generic k-way merge requires KM_NAME to be defined. It \
+can not use the type, since it might be a pointer.
+    #define KM_NAME km_int // For purposes of testing.
+#endif
+
+#if !defined(KM_CMP)
+    #error Error: Generic k-way merge requires KM_CMP to be defined. KM_CMP \
+works like HP_CMP in horror/heap.c with direct storage: it says whether one \
+element comes before the other, and every source must already be in that order.
+    #define KM_CMP(x, y) ((x) < (y)) // For purposes of testing.
+#endif
+
+#if !defined(KM_TYPE)
+    #define KM_TYPE HR_CONCAT(KM_NAME, _t)
+#endif
+
+// The number of elements pulled from a callback source at a time.
+#if !defined(KM_BLOCK)
+    #define KM_BLOCK 1024
+#endif
+
+
+#if KM_SCOPE == HR_SCOPE_NONE
+    #define KM_FUNC
+#elif KM_SCOPE == HR_SCOPE_STATIC
+    #define KM_FUNC static
+#elif KM_SCOPE == HR_SCOPE_STATIC_INLINE
+    #define KM_FUNC static inline
+#elif KM_SCOPE == HR_SCOPE_EXTERN_INLINE
+    #define KM_FUNC extern inline
+#else
+    #error Error: Generic k-way merge requires KM_SCOPE to be defined.
+    #define KM_FUNC // For testing purposes.
+#endif
+
+#define KM_CURSOR HR_CONCAT(KM_NAME, _cursor_t)
+#define KM_PULL HR_CONCAT(KM_NAME, _pull_t)
+#define KM_HEAP HR_CONCAT(KM_NAME, _heap)
+#define KM_ENTRY HR_CONCAT(KM_NAME, _entry_t)
+
+// The element a cursor is at.
+#define KM_HEAD(c) ((c)->data[(c)->pos])
+
+
+typedef struct KM_TYPE KM_TYPE;
+
+// Fills `buf` with up to `n` of a source's next elements, and returns how
+// many it wrote; zero means the source is exhausted.
+typedef size_t (*KM_PULL)(void* ctx, KM_ELEM_TYPE* buf, size_t n);
+
+
+#if KM_SCOPE != HR_SCOPE_HEADER && KM_SCOPE != HR_SCOPE_EXTERN_INLINE
+
+// Where a source is up to: `pos` in the `fill` elements at `data`, which is
+// either the whole of an array source or a block pulled into `buf`.
+typedef struct KM_CURSOR {
+    const KM_ELEM_TYPE* data;
+    size_t pos;
+    size_t fill;
+    KM_PULL pull;
+    void* ctx;
+    KM_ELEM_TYPE* buf;
+} KM_CURSOR;
+
+#if defined(KM_LOSER_TREE)
+// A contestant in the loser tree: a copy of a source's head, so that matches
+// never have to go through the cursors, and the source it's from. Exhausted
+// sources, and the padding past the last one, have `src` at SIZE_MAX.
+typedef struct KM_ENTRY {
+    KM_ELEM_TYPE key;
+    size_t src;
+} KM_ENTRY;
+#else
+#define HP_SCOPE KM_SCOPE
+#define HP_STORAGE HR_STORAGE_BORROWED_INDIRECT
+#define HP_ELEM_TYPE KM_CURSOR
+#define HP_NAME KM_HEAP
+#define HP_CMP(x, y) KM_CMP((KM_HEAD(x)), (KM_HEAD(y)))
+#include "horror/heap.c"
+#endif
+
+#endif
+
+#define NAME_(n) HR_CONCAT(KM_NAME, n)
+
+
+KM_FUNC bool NAME_(_init)(KM_TYPE* km);
+KM_FUNC void NAME_(_cleanup)(KM_TYPE* km);
+KM_FUNC bool NAME_(_add_array)(KM_TYPE* km, const KM_ELEM_TYPE* elems, size_t n);
+KM_FUNC bool NAME_(_add_source)(KM_TYPE* km, KM_PULL pull, void* ctx);
+KM_FUNC size_t NAME_(_next)(KM_TYPE* km, KM_ELEM_TYPE* out, size_t n);
+
+#if KM_SCOPE != HR_SCOPE_HEADER && KM_SCOPE != HR_SCOPE_EXTERN_INLINE
+
+// Sources are added up front; the first call to _next starts the merge,
+// after which the cursor array stays put. The sources still going are kept
+// in a heap keyed on their heads, or with KM_LOSER_TREE, in a tournament
+// tree over `_leaves` leaves, whose internal nodes hold the loser of each
+// match and whose `_tree[0]` is the overall winner.
+struct KM_TYPE {
+    KM_CURSOR* _cursors;
+    size_t _k;
+    size_t _size;
+    bool _started;
+#if defined(KM_LOSER_TREE)
+    KM_ENTRY* _tree;
+    size_t _leaves;
+#else
+    HR_CONCAT(KM_HEAP, _t) _heap;
+#endif
+};
+
+
+KM_FUNC bool NAME_(_init)(KM_TYPE* km) {
+    km->_cursors = NULL;
+    km->_k = 0;
+    km->_size = 0;
+    km->_started = false;
+#if defined(KM_LOSER_TREE)
+    km->_tree = NULL;
+    km->_leaves = 0;
+#else
+    if (!HR_CONCAT(KM_HEAP, _init)(&km->_heap, 16)) {
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+
+KM_FUNC void NAME_(_cleanup)(KM_TYPE* km) {
+    for (size_t i = 0; i < km->_k; i++) {
+        free(km->_cursors[i].buf);
+    }
+
+    free(km->_cursors);
+#if defined(KM_LOSER_TREE)
+    free(km->_tree);
+#else
+    HR_CONCAT(KM_HEAP, _cleanup)(&km->_heap);
+#endif
+}
+
+
+KM_FUNC KM_CURSOR* NAME_(_new_cursor)(KM_TYPE* km) {
+    assert(!km->_started);
+
+    if (km->_k == km->_size) {
+        size_t size = km->_size > 0 ? 2 * km->_size : 8;
+        KM_CURSOR* cursors = (KM_CURSOR*)realloc(km->_cursors, size * sizeof(KM_CURSOR));
+
+        if (cursors == NULL) {
+            return NULL;
+        }
+
+        km->_cursors = cursors;
+        km->_size = size;
+    }
+
+    return &km->_cursors[km->_k++];
+}
+
+
+// Add a source which is the `n` sorted elements at `elems`. They aren't
+// copied, and must stay put until the merge is done.
+KM_FUNC bool NAME_(_add_array)(KM_TYPE* km, const KM_ELEM_TYPE* elems, size_t n) {
+    KM_CURSOR* c = NAME_(_new_cursor)(km);
+
+    if (c == NULL) {
+        return false;
+    }
+
+    c->data = elems;
+    c->pos = 0;
+    c->fill = n;
+    c->pull = NULL;
+    c->ctx = NULL;
+    c->buf = NULL;
+
+    return true;
+}
+
+
+// Add a source whose elements are pulled KM_BLOCK at a time from `pull`.
+KM_FUNC bool NAME_(_add_source)(KM_TYPE* km, KM_PULL pull, void* ctx) {
+    KM_ELEM_TYPE* buf = (KM_ELEM_TYPE*)malloc(KM_BLOCK * sizeof(KM_ELEM_TYPE));
+
+    if (buf == NULL) {
+        return false;
+    }
+
+    KM_CURSOR* c = NAME_(_new_cursor)(km);
+
+    if (c == NULL) {
+        free(buf);
+        return false;
+    }
+
+    c->data = buf;
+    c->pos = 0;
+    c->fill = 0;
+    c->pull = pull;
+    c->ctx = ctx;
+    c->buf = buf;
+
+    return true;
+}
+
+
+// Whether `c` has an element at its head, pulling the next block if it's
+// used up the last one.
+KM_FUNC bool NAME_(_live)(KM_CURSOR* c) {
+    if (c->pos < c->fill) {
+        return true;
+    }
+
+    if (c->pull == NULL) {
+        return false;
+    }
+
+    c->pos = 0;
+    c->fill = c->pull(c->ctx, c->buf, KM_BLOCK);
+
+    return c->fill > 0;
+}
+
+
+#if defined(KM_LOSER_TREE)
+// Whether `a` beats `b`. Ties go to the earlier source, which makes the merge
+// stable.
+KM_FUNC bool NAME_(_beats)(const KM_ENTRY* a, const KM_ENTRY* b) {
+    if (a->src == SIZE_MAX) {
+        return false;
+    }
+
+    if (b->src == SIZE_MAX || KM_CMP((a->key), (b->key))) {
+        return true;
+    }
+
+    return a->src < b->src && !KM_CMP((b->key), (a->key));
+}
+
+
+// Source `i`'s entry: its head, or a sentinel once it's exhausted.
+KM_FUNC KM_ENTRY NAME_(_entry)(KM_TYPE* km, size_t i) {
+    KM_ENTRY e;
+
+    if (i < km->_k && km->_cursors[i].pos < km->_cursors[i].fill) {
+        e.key = KM_HEAD(&km->_cursors[i]);
+        e.src = i;
+    } else {
+        e.src = SIZE_MAX;
+    }
+
+    return e;
+}
+
+
+// Play source `i`'s new entry back up from its leaf to the root, against the
+// loser stored at each node on the way.
+KM_FUNC void NAME_(_replay)(KM_TYPE* km, size_t i) {
+    KM_ENTRY winner = NAME_(_entry)(km, i);
+
+    for (size_t node = (km->_leaves + i) / 2; node > 0; node /= 2) {
+        if (NAME_(_beats)(&km->_tree[node], &winner)) {
+            KM_ENTRY loser = winner;
+            winner = km->_tree[node];
+            km->_tree[node] = loser;
+        }
+    }
+
+    km->_tree[0] = winner;
+}
+#endif
+
+
+// Prime every cursor and seat them all in the heap or tree. If that fails, it
+// can be tried again on the next call to _next.
+KM_FUNC bool NAME_(_start)(KM_TYPE* km) {
+    for (size_t i = 0; i < km->_k; i++) {
+        NAME_(_live)(&km->_cursors[i]);
+    }
+
+#if defined(KM_LOSER_TREE)
+    km->_leaves = 1;
+    while (km->_leaves < km->_k) {
+        km->_leaves *= 2;
+    }
+
+    // Each node's winner, from the leaves up, as scratch space next to the
+    // losers the tree keeps.
+    KM_ENTRY* winners = (KM_ENTRY*)malloc(2 * km->_leaves * sizeof(KM_ENTRY));
+    km->_tree = (KM_ENTRY*)malloc(km->_leaves * sizeof(KM_ENTRY));
+
+    if (winners == NULL || km->_tree == NULL) {
+        free(winners);
+        free(km->_tree);
+        km->_tree = NULL;
+        return false;
+    }
+
+    for (size_t i = 0; i < km->_leaves; i++) {
+        winners[km->_leaves + i] = NAME_(_entry)(km, i);
+    }
+
+    for (size_t node = km->_leaves - 1; node > 0; node--) {
+        KM_ENTRY* a = &winners[2 * node];
+        KM_ENTRY* b = &winners[2 * node + 1];
+
+        if (NAME_(_beats)(b, a)) {
+            winners[node] = *b;
+            km->_tree[node] = *a;
+        } else {
+            winners[node] = *a;
+            km->_tree[node] = *b;
+        }
+    }
+
+    km->_tree[0] = winners[1];
+    free(winners);
+#else
+    for (size_t i = 0; i < km->_k; i++) {
+        KM_CURSOR* c = &km->_cursors[i];
+
+        if (c->pos < c->fill && !HR_CONCAT(KM_HEAP, _insert)(&km->_heap, c)) {
+            while (HR_CONCAT(KM_HEAP, _size)(&km->_heap) > 0) {
+                HR_CONCAT(KM_HEAP, _extract)(&km->_heap);
+            }
+            return false;
+        }
+    }
+#endif
+
+    km->_started = true;
+
+    return true;
+}
+
+
+// Write up to `n` of the next elements of the merged stream to `out`, and
+// return how many were written. Fewer than `n` means the sources are all
+// exhausted (or the merge couldn't allocate what it needed to start).
+KM_FUNC size_t NAME_(_next)(KM_TYPE* km, KM_ELEM_TYPE* out, size_t n) {
+    if (!km->_started && !NAME_(_start)(km)) {
+        return 0;
+    }
+
+    size_t written = 0;
+
+#if defined(KM_LOSER_TREE)
+    while (written < n) {
+        // Once the winner is a sentinel, every source is exhausted.
+        size_t i = km->_tree[0].src;
+
+        if (i == SIZE_MAX) {
+            break;
+        }
+
+        KM_CURSOR* c = &km->_cursors[i];
+
+        out[written++] = km->_tree[0].key;
+        c->pos++;
+        NAME_(_live)(c);
+        NAME_(_replay)(km, i);
+    }
+#else
+    while (written < n && HR_CONCAT(KM_HEAP, _size)(&km->_heap) > 0) {
+        KM_CURSOR* c = HR_CONCAT(KM_HEAP, _peek)(&km->_heap);
+
+        out[written++] = KM_HEAD(c);
+        c->pos++;
+
+        // The cursor's new head can only have moved it away from the root,
+        // so one sift-down puts it back in its place.
+        if (NAME_(_live)(c)) {
+            HR_CONCAT(KM_HEAP, _replace)(&km->_heap, c);
+        } else {
+            HR_CONCAT(KM_HEAP, _extract)(&km->_heap);
+        }
+    }
+#endif
+
+    return written;
+}
+
+#endif
+
+
+#undef KM_ELEM_TYPE
+#undef KM_NAME
+#undef KM_CMP
+#undef KM_TYPE
+#undef KM_SCOPE
+#undef KM_FUNC
+#undef KM_BLOCK
+#undef KM_LOSER_TREE
+#undef KM_CURSOR
+#undef KM_PULL
+#undef KM_HEAP
+#undef KM_ENTRY
+#undef KM_HEAD
+#undef NAME_
@@ -46,6 +46,11 @@ SOFTWARE.
 #define HR_STORAGE_BORROWED_INDIRECT 3
 
 
+#define HR_SIMD_INT32 1
+#define HR_SIMD_INT64 2
+#define HR_SIMD_FLOAT 3
+
+
 typedef int _horror_macro_h_please_the_gods;
 
 #endif
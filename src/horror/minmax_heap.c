@@ -0,0 +1,439 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "horror/macro.h"
+
+
+#if !defined(MM_ELEM_TYPE)
+    #error Error: Generic min-max heap requires MM_ELEM_TYPE to be defined.
+    #define MM_ELEM_TYPE char // For purposes of testing.
+#endif
+
+#if !defined(MM_NAME)
+    #error Error: Generic min-max heap requires MM_NAME to be defined. It \
+can not use the type, since it might be a pointer.
+    #define MM_NAME mm_char // For purposes of testing.
+#endif
+
+#if !defined(MM_CMP)
+    #error Error: Generic min-max heap requires MM_CMP to be defined. MM_CMP \
+must be a function or function-like macro which takes two arguments and \
+returns a boolean value (0 or 1) indicating whether or not the first argument \
+comes before the other. The "min" end of the heap is whatever comes first.
+    #define MM_CMP(x, y) ((x) < (y)) // For purposes of testing.
+#endif
+
+#if MM_STORAGE == HR_STORAGE_OWNED_INDIRECT && (!defined(MM_MALLOC_ELEM) || !defined(MM_FREE_ELEM))
+    #if defined(MM_MALLOC_ELEM)
+        #error Error: Generic min-max heap is given a custom MM_MALLOC_ELEM, but \
+not a custom MM_FREE_ELEM! This is dangerous, potentially even more dangerous than \
+deciding to use this library in the first place. Please define a custom MM_FREE_ELEM.
+    #endif
+
+    #if defined(MM_FREE_ELEM)
+        #error Error: Generic min-max heap is given a custom MM_FREE_ELEM, but \
+not a custom MM_MALLOC_ELEM! This is dangerous, potentially even more dangerous \
+than deciding to use this library in the first place. Please define a custom \
+MM_MALLOC_ELEM.
+    #endif
+
+    #define MM_MALLOC_ELEM (malloc(sizeof(MM_ELEM_TYPE)))
+    #define MM_FREE_ELEM(ptr) (free(ptr))
+#endif
+
+#if MM_STORAGE == HR_STORAGE_OWNED_INDIRECT && !defined(MM_MEMCPY_ELEM)
+    #define MM_MEMCPY_ELEM(dst, src) (memcpy(dst, src, sizeof(MM_ELEM_TYPE)))
+#endif
+
+#if !defined(MM_TYPE)
+    #define MM_TYPE HR_CONCAT(MM_NAME, _t)
+#endif
+
+
+#if MM_SCOPE == HR_SCOPE_NONE
+    #define MM_FUNC
+#elif MM_SCOPE == HR_SCOPE_STATIC
+    #define MM_FUNC static
+#elif MM_SCOPE == HR_SCOPE_STATIC_INLINE
+    #define MM_FUNC static inline
+#elif MM_SCOPE == HR_SCOPE_EXTERN_INLINE
+    #define MM_FUNC extern inline
+#else
+    #error Error: Generic min-max heap requires MM_SCOPE to be defined.
+    #define MM_FUNC // For testing purposes.
+#endif
+
+#if !defined(MM_STORAGE)
+    #error Error: Generic min-max heap requires MM_STORAGE to be defined.
+    #define MM_STORAGE HR_STORAGE_DIRECT // For testing purposes.
+#endif
+
+#define NAME_(n) HR_CONCAT(MM_NAME, n)
+
+#define MM_PARENT(loc) (((loc) - 1) / 2)
+#define MM_CHILD(loc) (2 * (loc) + 1)
+
+#if MM_STORAGE == HR_STORAGE_DIRECT
+    #define MM_SLOT MM_ELEM_TYPE
+#else
+    #define MM_SLOT MM_ELEM_TYPE*
+#endif
+
+// Whether `x` belongs above `y` on a level of the given kind: on min levels
+// that's when it comes first, on max levels when it comes last.
+#define MM_ABOVE(max, x, y) ((max) ? MM_CMP((y), (x)) : MM_CMP((x), (y)))
+
+
+typedef struct MM_TYPE MM_TYPE;
+
+
+MM_FUNC bool NAME_(_init)(MM_TYPE* mm, size_t _size);
+MM_FUNC void NAME_(_cleanup)(MM_TYPE* mm);
+MM_FUNC bool NAME_(_conditional_resize)(MM_TYPE* mm, size_t req);
+
+#if MM_STORAGE == HR_STORAGE_DIRECT
+MM_FUNC bool NAME_(_insert)(MM_TYPE* mm, MM_ELEM_TYPE elem);
+MM_FUNC MM_ELEM_TYPE NAME_(_extract_min)(MM_TYPE* mm);
+MM_FUNC MM_ELEM_TYPE NAME_(_extract_max)(MM_TYPE* mm);
+#elif MM_STORAGE == HR_STORAGE_OWNED_INDIRECT
+MM_FUNC bool NAME_(_insert)(MM_TYPE* mm, MM_ELEM_TYPE* elem);
+MM_FUNC void NAME_(_extract_min)(MM_TYPE* mm, MM_ELEM_TYPE* dst);
+MM_FUNC void NAME_(_extract_max)(MM_TYPE* mm, MM_ELEM_TYPE* dst);
+#elif MM_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+MM_FUNC bool NAME_(_insert)(MM_TYPE* mm, MM_ELEM_TYPE* elem);
+MM_FUNC MM_ELEM_TYPE* NAME_(_extract_min)(MM_TYPE* mm);
+MM_FUNC MM_ELEM_TYPE* NAME_(_extract_max)(MM_TYPE* mm);
+#endif
+
+MM_FUNC MM_ELEM_TYPE* NAME_(_peek_min)(MM_TYPE* mm);
+MM_FUNC MM_ELEM_TYPE* NAME_(_peek_max)(MM_TYPE* mm);
+MM_FUNC size_t NAME_(_size)(MM_TYPE* mm);
+
+#if MM_SCOPE != HR_SCOPE_HEADER && MM_SCOPE != HR_SCOPE_EXTERN_INLINE
+
+// The root's level, and every other level below it, holds the minimum of its
+// subtree; the levels in between hold the maximum.
+struct MM_TYPE {
+    size_t _used;
+    size_t _size;
+    MM_SLOT* _data;
+};
+
+
+MM_FUNC bool NAME_(_init)(MM_TYPE* mm, size_t _size) {
+    mm->_size = (_size > 0 ? _size : 1);
+    mm->_data = (MM_SLOT*)malloc(mm->_size * sizeof(MM_SLOT));
+
+    if (mm->_data == NULL) {
+        return false;
+    }
+
+    mm->_used = 0;
+
+    return true;
+}
+
+
+MM_FUNC void NAME_(_cleanup)(MM_TYPE* mm) {
+#if MM_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    for (size_t i = 0; i < mm->_used; i++) {
+        MM_FREE_ELEM((mm->_data[i]));
+    }
+#endif
+    free(mm->_data);
+}
+
+
+MM_FUNC bool NAME_(_conditional_resize)(MM_TYPE* mm, size_t req) {
+    if (mm->_size >= req) {
+        return true;
+    }
+
+    size_t size = mm->_size;
+    while (size < req) {
+        size *= 2;
+    }
+
+    // On failure, the heap keeps its old buffer and is left untouched.
+    MM_SLOT* data = (MM_SLOT*)realloc(mm->_data, size * sizeof(MM_SLOT));
+
+    if (data == NULL) {
+        return false;
+    }
+
+    mm->_data = data;
+    mm->_size = size;
+
+    return true;
+}
+
+
+MM_FUNC bool NAME_(_is_max_level)(size_t loc) {
+    bool max = false;
+
+    for (loc += 1; loc > 1; loc >>= 1) {
+        max = !max;
+    }
+
+    return max;
+}
+
+
+// Sift `x` up from the hole at `loc` along the levels of its own kind,
+// skipping a level at a time.
+MM_FUNC void NAME_(_sift_up)(MM_TYPE* mm, size_t loc, MM_SLOT x, bool max) {
+    MM_SLOT* data = mm->_data;
+
+    while (loc > 2 && MM_ABOVE(max, x, data[MM_PARENT(MM_PARENT(loc))])) {
+        data[loc] = data[MM_PARENT(MM_PARENT(loc))];
+        loc = MM_PARENT(MM_PARENT(loc));
+    }
+
+    data[loc] = x;
+}
+
+
+// Sift `x` down from the hole at `loc`, which is on a max level if `max` is
+// set. Each step looks at all of the hole's children and grandchildren, and
+// moves up whichever of them belongs highest if it belongs above `x`. When
+// that's a grandchild, `x` might now belong above the grandchild's parent,
+// which is of the opposite kind, in which case the two trade places and the
+// parent's old element carries on down instead.
+MM_FUNC void NAME_(_sift_down)(MM_TYPE* mm, size_t loc, MM_SLOT x, bool max) {
+    MM_SLOT* data = mm->_data;
+    size_t used = mm->_used;
+
+    for (;;) {
+        size_t child = MM_CHILD(loc);
+
+        if (child >= used) {
+            break;
+        }
+
+        size_t best = child;
+
+        if (child + 1 < used && MM_ABOVE(max, data[child + 1], data[best])) {
+            best = child + 1;
+        }
+
+        size_t grandchild = MM_CHILD(child), end = grandchild + 4;
+
+        if (end > used) {
+            end = used;
+        }
+
+        for (; grandchild < end; grandchild++) {
+            if (MM_ABOVE(max, data[grandchild], data[best])) {
+                best = grandchild;
+            }
+        }
+
+        if (!MM_ABOVE(max, data[best], x)) {
+            break;
+        }
+
+        data[loc] = data[best];
+        loc = best;
+
+        if (best <= child + 1) {
+            break;
+        }
+
+        if (MM_ABOVE(!max, x, data[MM_PARENT(best)])) {
+            MM_SLOT tmp = data[MM_PARENT(best)];
+            data[MM_PARENT(best)] = x;
+            x = tmp;
+        }
+    }
+
+    data[loc] = x;
+}
+
+
+// Fill the hole at `loc` with the last element, after `used` has already
+// been decremented.
+MM_FUNC void NAME_(_fill_hole)(MM_TYPE* mm, size_t loc) {
+    if (loc < mm->_used) {
+        NAME_(_sift_down)(mm, loc, mm->_data[mm->_used], NAME_(_is_max_level)(loc));
+    }
+}
+
+
+// Where the max lives: the root if it's alone, otherwise the greater of its
+// children, which head the first max level.
+MM_FUNC size_t NAME_(_max_loc)(MM_TYPE* mm) {
+    if (mm->_used < 3) {
+        return mm->_used - 1;
+    }
+
+    return MM_CMP((mm->_data[1]), (mm->_data[2])) ? 2 : 1;
+}
+
+
+#if MM_STORAGE == HR_STORAGE_DIRECT
+MM_FUNC bool NAME_(_insert)(MM_TYPE* mm, MM_ELEM_TYPE elem)
+#else
+MM_FUNC bool NAME_(_insert)(MM_TYPE* mm, MM_ELEM_TYPE* elem)
+#endif
+{
+    if (!NAME_(_conditional_resize)(mm, mm->_used + 1)) return false;
+
+    MM_SLOT slot;
+
+#if MM_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    slot = (MM_ELEM_TYPE*)(MM_MALLOC_ELEM);
+
+    if (slot == NULL) {
+        return false;
+    }
+
+    MM_MEMCPY_ELEM(slot, elem);
+#else
+    slot = elem;
+#endif
+
+    size_t loc = mm->_used++;
+
+    if (loc == 0) {
+        mm->_data[0] = slot;
+        return true;
+    }
+
+    // The new element either stays on its own level's kind, or belongs above
+    // its parent, in which case the parent comes down and it carries on up the
+    // parent's levels instead.
+    bool max = NAME_(_is_max_level)(loc);
+    size_t parent = MM_PARENT(loc);
+
+    if (MM_ABOVE(!max, slot, mm->_data[parent])) {
+        mm->_data[loc] = mm->_data[parent];
+        NAME_(_sift_up)(mm, parent, slot, !max);
+    } else {
+        NAME_(_sift_up)(mm, loc, slot, max);
+    }
+
+    return true;
+}
+
+
+#if MM_STORAGE == HR_STORAGE_DIRECT
+MM_FUNC MM_ELEM_TYPE NAME_(_extract_min)(MM_TYPE* mm)
+#elif MM_STORAGE == HR_STORAGE_OWNED_INDIRECT
+MM_FUNC void NAME_(_extract_min)(MM_TYPE* mm, MM_ELEM_TYPE* dst)
+#elif MM_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+MM_FUNC MM_ELEM_TYPE* NAME_(_extract_min)(MM_TYPE* mm)
+#endif
+{
+    assert(mm->_used > 0);
+
+    MM_SLOT root = mm->_data[0];
+
+    mm->_used -= 1;
+    NAME_(_fill_hole)(mm, 0);
+
+#if MM_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    MM_MEMCPY_ELEM((dst), (root));
+    MM_FREE_ELEM((root));
+#else
+    return root;
+#endif
+}
+
+
+#if MM_STORAGE == HR_STORAGE_DIRECT
+MM_FUNC MM_ELEM_TYPE NAME_(_extract_max)(MM_TYPE* mm)
+#elif MM_STORAGE == HR_STORAGE_OWNED_INDIRECT
+MM_FUNC void NAME_(_extract_max)(MM_TYPE* mm, MM_ELEM_TYPE* dst)
+#elif MM_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+MM_FUNC MM_ELEM_TYPE* NAME_(_extract_max)(MM_TYPE* mm)
+#endif
+{
+    assert(mm->_used > 0);
+
+    size_t loc = NAME_(_max_loc)(mm);
+    MM_SLOT max = mm->_data[loc];
+
+    mm->_used -= 1;
+    NAME_(_fill_hole)(mm, loc);
+
+#if MM_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    MM_MEMCPY_ELEM((dst), (max));
+    MM_FREE_ELEM((max));
+#else
+    return max;
+#endif
+}
+
+
+MM_FUNC MM_ELEM_TYPE* NAME_(_peek_min)(MM_TYPE* mm) {
+    assert(mm->_used > 0);
+#if MM_STORAGE == HR_STORAGE_DIRECT
+    return &mm->_data[0];
+#else
+    return mm->_data[0];
+#endif
+}
+
+
+MM_FUNC MM_ELEM_TYPE* NAME_(_peek_max)(MM_TYPE* mm) {
+    assert(mm->_used > 0);
+#if MM_STORAGE == HR_STORAGE_DIRECT
+    return &mm->_data[NAME_(_max_loc)(mm)];
+#else
+    return mm->_data[NAME_(_max_loc)(mm)];
+#endif
+}
+
+
+MM_FUNC size_t NAME_(_size)(MM_TYPE* mm) {
+    return mm->_used;
+}
+
+#endif
+
+
+#undef MM_ELEM_TYPE
+#undef MM_NAME
+#undef MM_CMP
+#undef MM_STORAGE
+#undef MM_MALLOC_ELEM
+#undef MM_FREE_ELEM
+#undef MM_MEMCPY_ELEM
+#undef MM_TYPE
+#undef MM_SCOPE
+#undef MM_FUNC
+#undef MM_PARENT
+#undef MM_CHILD
+#undef MM_SLOT
+#undef MM_ABOVE
+#undef NAME_
@@ -0,0 +1,363 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "horror/macro.h"
+
+
+#if !defined(MQ_ELEM_TYPE)
+    #error Error: Generic multiqueue requires MQ_ELEM_TYPE to be defined.
+    #define MQ_ELEM_TYPE char // For purposes of testing.
+#endif
+
+#if !defined(MQ_NAME)
+    #error Error: Generic multiqueue requires MQ_NAME to be defined. It \
+can not use the type, since it might be a pointer.
+    #define MQ_NAME mq_char // For purposes of testing.
+#endif
+
+#if !defined(MQ_CMP)
+    #error Error: Generic multiqueue requires MQ_CMP to be defined. MQ_CMP \
+works like HP_CMP in horror/heap.c, and is handed to each of the shards.
+    #define MQ_CMP(x, y) ((x) < (y)) // For purposes of testing.
+#endif
+
+#if !defined(MQ_TYPE)
+    #define MQ_TYPE HR_CONCAT(MQ_NAME, _t)
+#endif
+
+// Shards are padded out to this, so that two of them never share a line.
+#if !defined(MQ_CACHE_LINE)
+    #define MQ_CACHE_LINE 64
+#endif
+
+
+#if MQ_SCOPE == HR_SCOPE_NONE
+    #define MQ_FUNC
+#elif MQ_SCOPE == HR_SCOPE_STATIC
+    #define MQ_FUNC static
+#elif MQ_SCOPE == HR_SCOPE_STATIC_INLINE
+    #define MQ_FUNC static inline
+#elif MQ_SCOPE == HR_SCOPE_EXTERN_INLINE
+    #define MQ_FUNC extern inline
+#else
+    #error Error: Generic multiqueue requires MQ_SCOPE to be defined.
+    #define MQ_FUNC // For testing purposes.
+#endif
+
+#if !defined(MQ_STORAGE)
+    #error Error: Generic multiqueue requires MQ_STORAGE to be defined.
+    #define MQ_STORAGE HR_STORAGE_DIRECT // For testing purposes.
+#endif
+
+#define MQ_HEAP HR_CONCAT(MQ_NAME, _heap)
+#define MQ_SHARD HR_CONCAT(MQ_NAME, _shard_t)
+
+// Comparing the roots of two shards, which their heaps hand out as pointers.
+#if MQ_STORAGE == HR_STORAGE_DIRECT
+    #define MQ_ROOT_CMP(x, y) MQ_CMP((*(x)), (*(y)))
+#else
+    #define MQ_ROOT_CMP(x, y) MQ_CMP((x), (y))
+#endif
+
+#if MQ_STORAGE == HR_STORAGE_DIRECT && !defined(MQ_MEMCPY_ELEM)
+    #define MQ_IN_PARAM MQ_ELEM_TYPE elem
+#else
+    #define MQ_IN_PARAM MQ_ELEM_TYPE* elem
+#endif
+
+#if MQ_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+    #define MQ_OUT_PARAM MQ_ELEM_TYPE** out
+#else
+    #define MQ_OUT_PARAM MQ_ELEM_TYPE* out
+#endif
+
+
+typedef struct MQ_TYPE MQ_TYPE;
+
+
+#if MQ_SCOPE != HR_SCOPE_HEADER && MQ_SCOPE != HR_SCOPE_EXTERN_INLINE
+
+#define HP_SCOPE MQ_SCOPE
+#define HP_STORAGE MQ_STORAGE
+#define HP_ELEM_TYPE MQ_ELEM_TYPE
+#define HP_NAME MQ_HEAP
+#define HP_CMP(x, y) MQ_CMP(x, y)
+#if defined(MQ_MALLOC_ELEM)
+    #define HP_MALLOC_ELEM MQ_MALLOC_ELEM
+#endif
+#if defined(MQ_FREE_ELEM)
+    #define HP_FREE_ELEM(ptr) MQ_FREE_ELEM(ptr)
+#endif
+#if defined(MQ_MEMCPY_ELEM)
+    #define HP_MEMCPY_ELEM(dst, src) MQ_MEMCPY_ELEM(dst, src)
+#endif
+#include "horror/heap.c"
+
+#endif
+
+#define NAME_(n) HR_CONCAT(MQ_NAME, n)
+
+
+MQ_FUNC bool NAME_(_init)(MQ_TYPE* mq, size_t shards, size_t shard_size);
+MQ_FUNC void NAME_(_cleanup)(MQ_TYPE* mq);
+MQ_FUNC bool NAME_(_insert)(MQ_TYPE* mq, MQ_IN_PARAM, uint64_t* rng);
+MQ_FUNC bool NAME_(_extract)(MQ_TYPE* mq, MQ_OUT_PARAM, uint64_t* rng);
+MQ_FUNC size_t NAME_(_size)(MQ_TYPE* mq);
+
+#if MQ_SCOPE != HR_SCOPE_HEADER && MQ_SCOPE != HR_SCOPE_EXTERN_INLINE
+
+typedef union MQ_SHARD {
+    struct {
+        pthread_mutex_t lock;
+        HR_CONCAT(MQ_HEAP, _t) heap;
+    } s;
+    char _pad[(sizeof(pthread_mutex_t) + sizeof(HR_CONCAT(MQ_HEAP, _t)) + MQ_CACHE_LINE - 1)
+              / MQ_CACHE_LINE * MQ_CACHE_LINE];
+} MQ_SHARD;
+
+
+// A MultiQueue: a relaxed priority queue for many threads, made of shards
+// which are each an ordinary heap behind a lock. Inserts go to a random
+// shard, and extracts take the better of the roots of two random shards, so
+// what comes out is only close to the front of the queue. Threads never wait
+// on a lock while another shard is free to try.
+struct MQ_TYPE {
+    MQ_SHARD* _shards;
+    size_t _n;
+};
+
+
+MQ_FUNC bool NAME_(_init)(MQ_TYPE* mq, size_t shards, size_t shard_size) {
+    assert(shards > 0);
+
+    // Each shard's size is a whole number of cache lines.
+    mq->_shards = (MQ_SHARD*)aligned_alloc(MQ_CACHE_LINE, shards * sizeof(MQ_SHARD));
+
+    if (mq->_shards == NULL) {
+        return false;
+    }
+
+    size_t i;
+    for (i = 0; i < shards; i++) {
+        if (!HR_CONCAT(MQ_HEAP, _init)(&mq->_shards[i].s.heap, shard_size)) {
+            break;
+        }
+
+        if (pthread_mutex_init(&mq->_shards[i].s.lock, NULL) != 0) {
+            HR_CONCAT(MQ_HEAP, _cleanup)(&mq->_shards[i].s.heap);
+            break;
+        }
+    }
+
+    if (i < shards) {
+        while (i-- > 0) {
+            pthread_mutex_destroy(&mq->_shards[i].s.lock);
+            HR_CONCAT(MQ_HEAP, _cleanup)(&mq->_shards[i].s.heap);
+        }
+
+        free(mq->_shards);
+        return false;
+    }
+
+    mq->_n = shards;
+
+    return true;
+}
+
+
+MQ_FUNC void NAME_(_cleanup)(MQ_TYPE* mq) {
+    for (size_t i = 0; i < mq->_n; i++) {
+        pthread_mutex_destroy(&mq->_shards[i].s.lock);
+        HR_CONCAT(MQ_HEAP, _cleanup)(&mq->_shards[i].s.heap);
+    }
+
+    free(mq->_shards);
+}
+
+
+// A random shard, from splitmix64 over the calling thread's own `rng`, which
+// may start out as anything.
+MQ_FUNC MQ_SHARD* NAME_(_pick)(MQ_TYPE* mq, uint64_t* rng) {
+    uint64_t z = (*rng += UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    z ^= z >> 31;
+
+    return &mq->_shards[(size_t)(((z >> 32) * (uint64_t)mq->_n) >> 32)];
+}
+
+
+// Lock a random shard, trying others while the ones picked are busy, and
+// only waiting on a lock after as many tries as there are shards.
+MQ_FUNC MQ_SHARD* NAME_(_lock_any)(MQ_TYPE* mq, uint64_t* rng) {
+    MQ_SHARD* shard;
+
+    for (size_t tries = 0; tries < mq->_n; tries++) {
+        shard = NAME_(_pick)(mq, rng);
+
+        if (pthread_mutex_trylock(&shard->s.lock) == 0) {
+            return shard;
+        }
+    }
+
+    shard = NAME_(_pick)(mq, rng);
+    pthread_mutex_lock(&shard->s.lock);
+
+    return shard;
+}
+
+
+MQ_FUNC void NAME_(_take)(MQ_SHARD* shard, MQ_OUT_PARAM) {
+#if MQ_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    HR_CONCAT(MQ_HEAP, _extract)(&shard->s.heap, out);
+#else
+    *out = HR_CONCAT(MQ_HEAP, _extract)(&shard->s.heap);
+#endif
+}
+
+
+// Returns false only if the element couldn't be stored.
+MQ_FUNC bool NAME_(_insert)(MQ_TYPE* mq, MQ_IN_PARAM, uint64_t* rng) {
+    MQ_SHARD* shard = NAME_(_lock_any)(mq, rng);
+    bool ok = HR_CONCAT(MQ_HEAP, _insert)(&shard->s.heap, elem);
+    pthread_mutex_unlock(&shard->s.lock);
+
+    return ok;
+}
+
+
+// Take an element from near the front of the queue into `out`. Returns false
+// if every shard was found empty, which is only certain to mean the queue is
+// empty while no other thread is inserting.
+MQ_FUNC bool NAME_(_extract)(MQ_TYPE* mq, MQ_OUT_PARAM, uint64_t* rng) {
+    for (size_t tries = 0; tries < 2 * mq->_n; tries++) {
+        MQ_SHARD* a = NAME_(_pick)(mq, rng);
+        MQ_SHARD* b = NAME_(_pick)(mq, rng);
+
+        if (pthread_mutex_trylock(&a->s.lock) != 0) {
+            continue;
+        }
+
+        // If the second shard is busy, settling for the first is better
+        // than waiting.
+        if (b == a || pthread_mutex_trylock(&b->s.lock) != 0) {
+            b = NULL;
+        }
+
+        MQ_SHARD* best = a;
+
+        if (b != NULL && HR_CONCAT(MQ_HEAP, _size)(&b->s.heap) > 0
+            && (HR_CONCAT(MQ_HEAP, _size)(&a->s.heap) == 0
+                || MQ_ROOT_CMP(HR_CONCAT(MQ_HEAP, _peek)(&b->s.heap),
+                               HR_CONCAT(MQ_HEAP, _peek)(&a->s.heap)))) {
+            best = b;
+        }
+
+        bool found = HR_CONCAT(MQ_HEAP, _size)(&best->s.heap) > 0;
+
+        if (found) {
+            NAME_(_take)(best, out);
+        }
+
+        pthread_mutex_unlock(&a->s.lock);
+        if (b != NULL) {
+            pthread_mutex_unlock(&b->s.lock);
+        }
+
+        if (found) {
+            return true;
+        }
+    }
+
+    // Random picks keep turning up empty shards, so the queue is nearly
+    // empty; go through all of them in turn before giving up.
+    size_t start = (size_t)(NAME_(_pick)(mq, rng) - mq->_shards);
+
+    for (size_t i = 0; i < mq->_n; i++) {
+        MQ_SHARD* shard = &mq->_shards[(start + i) % mq->_n];
+
+        pthread_mutex_lock(&shard->s.lock);
+
+        bool found = HR_CONCAT(MQ_HEAP, _size)(&shard->s.heap) > 0;
+
+        if (found) {
+            NAME_(_take)(shard, out);
+        }
+
+        pthread_mutex_unlock(&shard->s.lock);
+
+        if (found) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+// The number of elements across all shards. Only exact while no other thread
+// is changing the queue.
+MQ_FUNC size_t NAME_(_size)(MQ_TYPE* mq) {
+    size_t size = 0;
+
+    for (size_t i = 0; i < mq->_n; i++) {
+        pthread_mutex_lock(&mq->_shards[i].s.lock);
+        size += HR_CONCAT(MQ_HEAP, _size)(&mq->_shards[i].s.heap);
+        pthread_mutex_unlock(&mq->_shards[i].s.lock);
+    }
+
+    return size;
+}
+
+#endif
+
+
+#undef MQ_ELEM_TYPE
+#undef MQ_NAME
+#undef MQ_CMP
+#undef MQ_STORAGE
+#undef MQ_MALLOC_ELEM
+#undef MQ_FREE_ELEM
+#undef MQ_MEMCPY_ELEM
+#undef MQ_TYPE
+#undef MQ_SCOPE
+#undef MQ_FUNC
+#undef MQ_CACHE_LINE
+#undef MQ_HEAP
+#undef MQ_SHARD
+#undef MQ_ROOT_CMP
+#undef MQ_IN_PARAM
+#undef MQ_OUT_PARAM
+#undef NAME_
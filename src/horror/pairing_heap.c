@@ -0,0 +1,468 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "horror/macro.h"
+
+
+#if !defined(PH_ELEM_TYPE)
+    #error Error: Generic pairing heap requires PH_ELEM_TYPE to be defined.
+    #define PH_ELEM_TYPE char // For purposes of testing.
+#endif
+
+#if !defined(PH_NAME)
+    #error Error: Generic pairing heap requires PH_NAME to be defined. It \
+can not use the type, since it might be a pointer.
+    #define PH_NAME ph_char // For purposes of testing.
+#endif
+
+#if !defined(PH_CMP)
+    #error Error: Generic pairing heap requires PH_CMP to be defined. PH_CMP \
+must be a function or function-like macro which takes two arguments and \
+returns a boolean value (0 or 1) indicating whether or not the first argument \
+precedes the other in the heap ordering, exactly as HP_CMP does for \
+horror/heap.c.
+    #define PH_CMP(x, y) ((x) < (y)) // For purposes of testing.
+#endif
+
+#if PH_STORAGE == HR_STORAGE_OWNED_INDIRECT && (!defined(PH_MALLOC_ELEM) || !defined(PH_FREE_ELEM))
+    #if defined(PH_MALLOC_ELEM)
+        #error Error: Generic pairing heap is given a custom PH_MALLOC_ELEM, but \
+not a custom PH_FREE_ELEM! This is dangerous, potentially even more dangerous than \
+deciding to use this library in the first place. Please define a custom PH_FREE_ELEM.
+    #endif
+
+    #if defined(PH_FREE_ELEM)
+        #error Error: Generic pairing heap is given a custom PH_FREE_ELEM, but \
+not a custom PH_MALLOC_ELEM! This is dangerous, potentially even more dangerous \
+than deciding to use this library in the first place. Please define a custom \
+PH_MALLOC_ELEM.
+    #endif
+
+    #define PH_MALLOC_ELEM (malloc(sizeof(PH_ELEM_TYPE)))
+    #define PH_FREE_ELEM(ptr) (free(ptr))
+#endif
+
+#if PH_STORAGE == HR_STORAGE_OWNED_INDIRECT && !defined(PH_MEMCPY_ELEM)
+    #define PH_MEMCPY_ELEM(dst, src) (memcpy(dst, src, sizeof(PH_ELEM_TYPE)))
+#endif
+
+#if !defined(PH_TYPE)
+    #define PH_TYPE HR_CONCAT(PH_NAME, _t)
+#endif
+
+#if !defined(PH_POOL_CHUNK)
+    #define PH_POOL_CHUNK 256
+#endif
+
+
+#if PH_SCOPE == HR_SCOPE_NONE
+    #define PH_FUNC
+#elif PH_SCOPE == HR_SCOPE_STATIC
+    #define PH_FUNC static
+#elif PH_SCOPE == HR_SCOPE_STATIC_INLINE
+    #define PH_FUNC static inline
+#elif PH_SCOPE == HR_SCOPE_EXTERN_INLINE
+    #define PH_FUNC extern inline
+#else
+    #error Error: Generic pairing heap requires PH_SCOPE to be defined.
+    #define PH_FUNC // For testing purposes.
+#endif
+
+#if !defined(PH_STORAGE)
+    #error Error: Generic pairing heap requires PH_STORAGE to be defined.
+    #define PH_STORAGE HR_STORAGE_DIRECT // For testing purposes.
+#endif
+
+#define NAME_(n) HR_CONCAT(PH_NAME, n)
+#define PH_NODE NAME_(_node_t)
+#define PH_CHUNK NAME_(_chunk_t)
+
+
+typedef struct PH_TYPE PH_TYPE;
+typedef struct PH_NODE PH_NODE;
+
+
+PH_FUNC void NAME_(_init)(PH_TYPE* ph);
+PH_FUNC void NAME_(_cleanup)(PH_TYPE* ph);
+
+#if PH_STORAGE == HR_STORAGE_DIRECT
+PH_FUNC PH_NODE* NAME_(_insert)(PH_TYPE* ph, PH_ELEM_TYPE elem);
+PH_FUNC PH_ELEM_TYPE NAME_(_extract)(PH_TYPE* ph);
+#elif PH_STORAGE == HR_STORAGE_OWNED_INDIRECT
+PH_FUNC PH_NODE* NAME_(_insert)(PH_TYPE* ph, PH_ELEM_TYPE* elem);
+PH_FUNC void NAME_(_extract)(PH_TYPE* ph, PH_ELEM_TYPE* dst);
+#elif PH_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+PH_FUNC PH_NODE* NAME_(_insert)(PH_TYPE* ph, PH_ELEM_TYPE* elem);
+PH_FUNC PH_ELEM_TYPE* NAME_(_extract)(PH_TYPE* ph);
+#endif
+
+PH_FUNC PH_ELEM_TYPE* NAME_(_peek)(PH_TYPE* ph);
+PH_FUNC PH_ELEM_TYPE* NAME_(_get)(PH_NODE* node);
+PH_FUNC void NAME_(_decrease_key)(PH_TYPE* ph, PH_NODE* node);
+PH_FUNC void NAME_(_meld)(PH_TYPE* ph, PH_TYPE* other);
+PH_FUNC size_t NAME_(_size)(PH_TYPE* ph);
+
+#if PH_SCOPE != HR_SCOPE_HEADER && PH_SCOPE != HR_SCOPE_EXTERN_INLINE
+
+// Each node's children form a doubly linked list through `next` and `prev`.
+// The first child's `prev` points back at its parent instead.
+struct PH_NODE {
+    PH_NODE* child;
+    PH_NODE* next;
+    PH_NODE* prev;
+#if PH_STORAGE == HR_STORAGE_DIRECT
+    PH_ELEM_TYPE data;
+#else
+    PH_ELEM_TYPE* data;
+#endif
+};
+
+
+// Nodes are carved out of chunks of PH_POOL_CHUNK at a time. Freed nodes go on
+// a free list, most recently freed first, and chunks are only given back at
+// _cleanup.
+typedef struct PH_CHUNK {
+    struct PH_CHUNK* next;
+    PH_NODE nodes[PH_POOL_CHUNK];
+} PH_CHUNK;
+
+
+struct PH_TYPE {
+    size_t _used;
+    PH_NODE* _root;
+    PH_NODE* _free;
+    PH_CHUNK* _chunks;
+    PH_CHUNK* _last_chunk;
+    size_t _chunk_used;
+};
+
+
+PH_FUNC void NAME_(_init)(PH_TYPE* ph) {
+    ph->_used = 0;
+    ph->_root = NULL;
+    ph->_free = NULL;
+    ph->_chunks = NULL;
+    ph->_last_chunk = NULL;
+    ph->_chunk_used = PH_POOL_CHUNK;
+}
+
+
+PH_FUNC void NAME_(_cleanup)(PH_TYPE* ph) {
+#if PH_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    // Walk the tree with the `next` links as a stack, so we don't need one.
+    PH_NODE* stack = ph->_root;
+
+    if (stack != NULL) {
+        stack->next = NULL;
+    }
+
+    while (stack != NULL) {
+        PH_NODE* node = stack;
+        stack = node->next;
+
+        for (PH_NODE* child = node->child, *next; child != NULL; child = next) {
+            next = child->next;
+            child->next = stack;
+            stack = child;
+        }
+
+        PH_FREE_ELEM((node->data));
+    }
+#endif
+
+    while (ph->_chunks != NULL) {
+        PH_CHUNK* next = ph->_chunks->next;
+        free(ph->_chunks);
+        ph->_chunks = next;
+    }
+}
+
+
+PH_FUNC PH_NODE* NAME_(_alloc_node)(PH_TYPE* ph) {
+    PH_NODE* node = ph->_free;
+
+    if (node != NULL) {
+        ph->_free = node->next;
+        return node;
+    }
+
+    if (ph->_chunk_used == PH_POOL_CHUNK) {
+        PH_CHUNK* chunk = (PH_CHUNK*)malloc(sizeof(PH_CHUNK));
+
+        if (chunk == NULL) {
+            return NULL;
+        }
+
+        chunk->next = ph->_chunks;
+        ph->_chunks = chunk;
+        ph->_chunk_used = 0;
+
+        if (ph->_last_chunk == NULL) {
+            ph->_last_chunk = chunk;
+        }
+    }
+
+    return &ph->_chunks->nodes[ph->_chunk_used++];
+}
+
+
+PH_FUNC void NAME_(_free_node)(PH_TYPE* ph, PH_NODE* node) {
+    node->next = ph->_free;
+    ph->_free = node;
+}
+
+
+// Link two roots, making the one which comes second the first child of the
+// other. Returns the new root.
+PH_FUNC PH_NODE* NAME_(_link)(PH_NODE* a, PH_NODE* b) {
+    if (PH_CMP((b->data), (a->data))) {
+        PH_NODE* tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    b->prev = a;
+    b->next = a->child;
+
+    if (a->child != NULL) {
+        a->child->prev = b;
+    }
+
+    a->child = b;
+
+    return a;
+}
+
+
+#if PH_STORAGE == HR_STORAGE_DIRECT
+PH_FUNC PH_NODE* NAME_(_insert)(PH_TYPE* ph, PH_ELEM_TYPE elem)
+#else
+PH_FUNC PH_NODE* NAME_(_insert)(PH_TYPE* ph, PH_ELEM_TYPE* elem)
+#endif
+{
+    PH_NODE* node = NAME_(_alloc_node)(ph);
+
+    if (node == NULL) {
+        return NULL;
+    }
+
+#if PH_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    node->data = (PH_ELEM_TYPE*)(PH_MALLOC_ELEM);
+
+    if (node->data == NULL) {
+        NAME_(_free_node)(ph, node);
+        return NULL;
+    }
+
+    PH_MEMCPY_ELEM(node->data, elem);
+#else
+    node->data = elem;
+#endif
+
+    node->child = node->next = node->prev = NULL;
+
+    ph->_root = ph->_root != NULL ? NAME_(_link)(ph->_root, node) : node;
+    ph->_used += 1;
+
+    return node;
+}
+
+
+// Merge the children of a removed root back into a single tree with the usual
+// two passes: link them pairwise from left to right, then fold the pairs
+// together from right to left.
+PH_FUNC PH_NODE* NAME_(_merge_children)(PH_NODE* first) {
+    PH_NODE* pairs = NULL;
+
+    while (first != NULL) {
+        PH_NODE* a = first;
+        PH_NODE* b = a->next;
+
+        if (b == NULL) {
+            first = NULL;
+        } else {
+            first = b->next;
+            b->next = b->prev = NULL;
+        }
+
+        a->next = a->prev = NULL;
+
+        if (b != NULL) {
+            a = NAME_(_link)(a, b);
+        }
+
+        // Pairs are pushed on a stack, so popping them walks right to left.
+        a->next = pairs;
+        pairs = a;
+    }
+
+    PH_NODE* root = pairs;
+
+    if (root != NULL) {
+        pairs = root->next;
+        root->next = NULL;
+
+        while (pairs != NULL) {
+            PH_NODE* next = pairs->next;
+            pairs->next = NULL;
+            root = NAME_(_link)(root, pairs);
+            pairs = next;
+        }
+    }
+
+    return root;
+}
+
+
+#if PH_STORAGE == HR_STORAGE_DIRECT
+PH_FUNC PH_ELEM_TYPE NAME_(_extract)(PH_TYPE* ph)
+#elif PH_STORAGE == HR_STORAGE_OWNED_INDIRECT
+PH_FUNC void NAME_(_extract)(PH_TYPE* ph, PH_ELEM_TYPE* dst)
+#elif PH_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+PH_FUNC PH_ELEM_TYPE* NAME_(_extract)(PH_TYPE* ph)
+#endif
+{
+    assert(ph->_used > 0);
+
+    PH_NODE* root = ph->_root;
+
+#if PH_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    PH_MEMCPY_ELEM((dst), (root->data));
+    PH_FREE_ELEM((root->data));
+#else
+    #if PH_STORAGE == HR_STORAGE_DIRECT
+    PH_ELEM_TYPE data = root->data;
+    #else
+    PH_ELEM_TYPE* data = root->data;
+    #endif
+#endif
+
+    ph->_root = NAME_(_merge_children)(root->child);
+    ph->_used -= 1;
+
+    NAME_(_free_node)(ph, root);
+
+#if PH_STORAGE != HR_STORAGE_OWNED_INDIRECT
+    return data;
+#endif
+}
+
+
+PH_FUNC PH_ELEM_TYPE* NAME_(_peek)(PH_TYPE* ph) {
+    assert(ph->_used > 0);
+#if PH_STORAGE == HR_STORAGE_DIRECT
+    return &ph->_root->data;
+#else
+    return ph->_root->data;
+#endif
+}
+
+
+PH_FUNC PH_ELEM_TYPE* NAME_(_get)(PH_NODE* node) {
+#if PH_STORAGE == HR_STORAGE_DIRECT
+    return &node->data;
+#else
+    return node->data;
+#endif
+}
+
+
+// Call after changing the element in `node` so that it moves toward the root.
+// The node's subtree is cut loose and linked back in at the root.
+PH_FUNC void NAME_(_decrease_key)(PH_TYPE* ph, PH_NODE* node) {
+    if (node == ph->_root) {
+        return;
+    }
+
+    if (node->prev->child == node) {
+        node->prev->child = node->next;
+    } else {
+        node->prev->next = node->next;
+    }
+
+    if (node->next != NULL) {
+        node->next->prev = node->prev;
+    }
+
+    node->next = node->prev = NULL;
+
+    ph->_root = NAME_(_link)(ph->_root, node);
+}
+
+
+// Move everything in `other` into `ph`, leaving `other` empty. `other`'s node
+// chunks come along too, so its nodes stay valid as handles into `ph`.
+PH_FUNC void NAME_(_meld)(PH_TYPE* ph, PH_TYPE* other) {
+    if (other->_root != NULL) {
+        ph->_root = ph->_root != NULL ? NAME_(_link)(ph->_root, other->_root) : other->_root;
+        ph->_used += other->_used;
+    }
+
+    // Append the other heap's chunks behind ours, so that our partially used
+    // chunk stays at the front. Its free nodes are simply dropped.
+    if (other->_chunks != NULL) {
+        if (ph->_chunks == NULL) {
+            ph->_chunks = other->_chunks;
+            ph->_chunk_used = PH_POOL_CHUNK;
+        } else {
+            ph->_last_chunk->next = other->_chunks;
+        }
+
+        ph->_last_chunk = other->_last_chunk;
+    }
+
+    NAME_(_init)(other);
+}
+
+
+PH_FUNC size_t NAME_(_size)(PH_TYPE* ph) {
+    return ph->_used;
+}
+
+#endif
+
+
+#undef PH_ELEM_TYPE
+#undef PH_NAME
+#undef PH_CMP
+#undef PH_STORAGE
+#undef PH_MALLOC_ELEM
+#undef PH_FREE_ELEM
+#undef PH_MEMCPY_ELEM
+#undef PH_TYPE
+#undef PH_SCOPE
+#undef PH_FUNC
+#undef PH_POOL_CHUNK
+#undef PH_NODE
+#undef PH_CHUNK
+#undef NAME_
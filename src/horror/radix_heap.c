@@ -0,0 +1,400 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "horror/macro.h"
+
+
+#if !defined(RX_ELEM_TYPE)
+    #error Error: Generic radix heap requires RX_ELEM_TYPE to be defined.
+    #define RX_ELEM_TYPE uint64_t // For purposes of testing.
+#endif
+
+#if !defined(RX_NAME)
+    #error Error: Generic radix heap requires RX_NAME to be defined. It \
+can not use the type, since it might be a pointer.
+    #define RX_NAME rx_u64 // For purposes of testing.
+#endif
+
+#if !defined(RX_KEY)
+    #error Error: Generic radix heap requires RX_KEY to be defined. RX_KEY \
+must be a function or function-like macro which takes an element (or, with \
+indirect storage, a pointer to one) and returns its priority as an RX_KEY_TYPE. \
+Smaller keys come out first, and no key may be inserted which is smaller than \
+the last one extracted.
+    #define RX_KEY(x) (x) // For purposes of testing.
+#endif
+
+#if !defined(RX_KEY_TYPE)
+    #define RX_KEY_TYPE uint64_t
+#endif
+
+#if RX_STORAGE == HR_STORAGE_OWNED_INDIRECT && (!defined(RX_MALLOC_ELEM) || !defined(RX_FREE_ELEM))
+    #if defined(RX_MALLOC_ELEM)
+        #error Error: Generic radix heap is given a custom RX_MALLOC_ELEM, but \
+not a custom RX_FREE_ELEM! This is dangerous, potentially even more dangerous than \
+deciding to use this library in the first place. Please define a custom RX_FREE_ELEM.
+    #endif
+
+    #if defined(RX_FREE_ELEM)
+        #error Error: Generic radix heap is given a custom RX_FREE_ELEM, but \
+not a custom RX_MALLOC_ELEM! This is dangerous, potentially even more dangerous \
+than deciding to use this library in the first place. Please define a custom \
+RX_MALLOC_ELEM.
+    #endif
+
+    #define RX_MALLOC_ELEM (malloc(sizeof(RX_ELEM_TYPE)))
+    #define RX_FREE_ELEM(ptr) (free(ptr))
+#endif
+
+#if RX_STORAGE == HR_STORAGE_OWNED_INDIRECT && !defined(RX_MEMCPY_ELEM)
+    #define RX_MEMCPY_ELEM(dst, src) (memcpy(dst, src, sizeof(RX_ELEM_TYPE)))
+#endif
+
+#if !defined(RX_TYPE)
+    #define RX_TYPE HR_CONCAT(RX_NAME, _t)
+#endif
+
+
+#if RX_SCOPE == HR_SCOPE_NONE
+    #define RX_FUNC
+#elif RX_SCOPE == HR_SCOPE_STATIC
+    #define RX_FUNC static
+#elif RX_SCOPE == HR_SCOPE_STATIC_INLINE
+    #define RX_FUNC static inline
+#elif RX_SCOPE == HR_SCOPE_EXTERN_INLINE
+    #define RX_FUNC extern inline
+#else
+    #error Error: Generic radix heap requires RX_SCOPE to be defined.
+    #define RX_FUNC // For testing purposes.
+#endif
+
+#if !defined(RX_STORAGE)
+    #error Error: Generic radix heap requires RX_STORAGE to be defined.
+    #define RX_STORAGE HR_STORAGE_DIRECT // For testing purposes.
+#endif
+
+#define NAME_(n) HR_CONCAT(RX_NAME, n)
+#define RX_ENTRY NAME_(_entry_t)
+#define RX_BUCKET NAME_(_bucket_t)
+
+#if RX_STORAGE == HR_STORAGE_DIRECT
+    #define RX_SLOT RX_ELEM_TYPE
+#else
+    #define RX_SLOT RX_ELEM_TYPE*
+#endif
+
+// Bucket 0 holds keys equal to the last one extracted, and bucket i > 0 the
+// keys whose highest bit differing from it is bit i - 1.
+#define RX_BUCKETS (sizeof(RX_KEY_TYPE) * CHAR_BIT + 1)
+
+#if defined(__GNUC__)
+    #define RX_BUCKET_OF(rx, key) \
+        ((key) == (rx)->_last ? 0 : \
+            (size_t)(sizeof(unsigned long long) * CHAR_BIT \
+                - __builtin_clzll((unsigned long long)((key) ^ (rx)->_last))))
+#else
+    #define RX_BUCKET_OF(rx, key) (NAME_(_bit_width)((key) ^ (rx)->_last))
+#endif
+
+
+typedef struct RX_TYPE RX_TYPE;
+
+
+RX_FUNC void NAME_(_init)(RX_TYPE* rx);
+RX_FUNC void NAME_(_cleanup)(RX_TYPE* rx);
+
+#if RX_STORAGE == HR_STORAGE_DIRECT
+RX_FUNC bool NAME_(_insert)(RX_TYPE* rx, RX_ELEM_TYPE elem);
+RX_FUNC RX_ELEM_TYPE NAME_(_extract)(RX_TYPE* rx);
+#elif RX_STORAGE == HR_STORAGE_OWNED_INDIRECT
+RX_FUNC bool NAME_(_insert)(RX_TYPE* rx, RX_ELEM_TYPE* elem);
+RX_FUNC void NAME_(_extract)(RX_TYPE* rx, RX_ELEM_TYPE* dst);
+#elif RX_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+RX_FUNC bool NAME_(_insert)(RX_TYPE* rx, RX_ELEM_TYPE* elem);
+RX_FUNC RX_ELEM_TYPE* NAME_(_extract)(RX_TYPE* rx);
+#endif
+
+RX_FUNC RX_ELEM_TYPE* NAME_(_peek)(RX_TYPE* rx);
+RX_FUNC RX_KEY_TYPE NAME_(_last_key)(RX_TYPE* rx);
+RX_FUNC size_t NAME_(_size)(RX_TYPE* rx);
+
+#if RX_SCOPE != HR_SCOPE_HEADER && RX_SCOPE != HR_SCOPE_EXTERN_INLINE
+
+// Keys are kept next to their elements, so that redistributing a bucket never
+// has to look at the elements themselves.
+typedef struct RX_ENTRY {
+    RX_KEY_TYPE key;
+    RX_SLOT elem;
+} RX_ENTRY;
+
+
+typedef struct RX_BUCKET {
+    size_t used;
+    size_t size;
+    RX_ENTRY* data;
+} RX_BUCKET;
+
+
+struct RX_TYPE {
+    size_t _used;
+    RX_KEY_TYPE _last;
+    RX_BUCKET _buckets[RX_BUCKETS];
+};
+
+
+#if !defined(__GNUC__)
+RX_FUNC size_t NAME_(_bit_width)(RX_KEY_TYPE x) {
+    size_t width = 0;
+
+    while (x != 0) {
+        x >>= 1;
+        width++;
+    }
+
+    return width;
+}
+#endif
+
+
+RX_FUNC void NAME_(_init)(RX_TYPE* rx) {
+    rx->_used = 0;
+    rx->_last = 0;
+
+    for (size_t i = 0; i < RX_BUCKETS; i++) {
+        rx->_buckets[i].used = 0;
+        rx->_buckets[i].size = 0;
+        rx->_buckets[i].data = NULL;
+    }
+}
+
+
+RX_FUNC void NAME_(_cleanup)(RX_TYPE* rx) {
+    for (size_t i = 0; i < RX_BUCKETS; i++) {
+#if RX_STORAGE == HR_STORAGE_OWNED_INDIRECT
+        for (size_t j = 0; j < rx->_buckets[i].used; j++) {
+            RX_FREE_ELEM((rx->_buckets[i].data[j].elem));
+        }
+#endif
+        free(rx->_buckets[i].data);
+    }
+}
+
+
+// Make room for at least `req` entries in `bucket`. Buckets keep their buffers
+// once they have them, so after warming up this rarely allocates.
+RX_FUNC bool NAME_(_reserve_bucket)(RX_BUCKET* bucket, size_t req) {
+    if (bucket->size >= req) {
+        return true;
+    }
+
+    size_t size = bucket->size > 0 ? bucket->size : 16;
+    while (size < req) {
+        size *= 2;
+    }
+
+    RX_ENTRY* data = (RX_ENTRY*)realloc(bucket->data, size * sizeof(RX_ENTRY));
+
+    if (data == NULL) {
+        return false;
+    }
+
+    bucket->data = data;
+    bucket->size = size;
+
+    return true;
+}
+
+
+// Find the smallest key, and make bucket 0 hold it if possible. Returns the
+// bucket holding it and sets `*loc` to where it is in that bucket.
+//
+// When bucket 0 is empty, the first bucket that isn't holds the smallest key.
+// That key becomes the new last key, and every entry of its bucket moves to a
+// lower one, since they now all share the bits above its highest differing
+// bit with it. If the lower buckets can't be grown to take them, the smallest
+// entry is handed out from where it is instead, without moving the last key.
+// That's slower, but keeps extraction from ever failing.
+RX_FUNC RX_BUCKET* NAME_(_settle)(RX_TYPE* rx, size_t* loc) {
+    assert(rx->_used > 0);
+
+    RX_BUCKET* buckets = rx->_buckets;
+
+    if (buckets[0].used > 0) {
+        *loc = buckets[0].used - 1;
+        return &buckets[0];
+    }
+
+    size_t i = 1;
+    while (buckets[i].used == 0) {
+        i++;
+    }
+
+    RX_BUCKET* from = &buckets[i];
+    size_t min = 0;
+
+    for (size_t j = 1; j < from->used; j++) {
+        if (from->data[j].key < from->data[min].key) {
+            min = j;
+        }
+    }
+
+    RX_KEY_TYPE last = rx->_last;
+    rx->_last = from->data[min].key;
+
+    size_t counts[RX_BUCKETS] = { 0 };
+
+    for (size_t j = 0; j < from->used; j++) {
+        counts[RX_BUCKET_OF(rx, from->data[j].key)]++;
+    }
+
+    for (size_t k = 0; k < i; k++) {
+        if (!NAME_(_reserve_bucket)(&buckets[k], counts[k])) {
+            rx->_last = last;
+            *loc = min;
+            return from;
+        }
+    }
+
+    for (size_t j = 0; j < from->used; j++) {
+        RX_BUCKET* to = &buckets[RX_BUCKET_OF(rx, from->data[j].key)];
+        to->data[to->used++] = from->data[j];
+    }
+
+    from->used = 0;
+
+    *loc = buckets[0].used - 1;
+    return &buckets[0];
+}
+
+
+#if RX_STORAGE == HR_STORAGE_DIRECT
+RX_FUNC bool NAME_(_insert)(RX_TYPE* rx, RX_ELEM_TYPE elem)
+#else
+RX_FUNC bool NAME_(_insert)(RX_TYPE* rx, RX_ELEM_TYPE* elem)
+#endif
+{
+    RX_ENTRY entry;
+
+    entry.key = RX_KEY((elem));
+    assert(entry.key >= rx->_last);
+
+    RX_BUCKET* bucket = &rx->_buckets[RX_BUCKET_OF(rx, entry.key)];
+
+    if (!NAME_(_reserve_bucket)(bucket, bucket->used + 1)) return false;
+
+#if RX_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    entry.elem = (RX_ELEM_TYPE*)(RX_MALLOC_ELEM);
+
+    if (entry.elem == NULL) {
+        return false;
+    }
+
+    RX_MEMCPY_ELEM(entry.elem, elem);
+#else
+    entry.elem = elem;
+#endif
+
+    bucket->data[bucket->used++] = entry;
+    rx->_used += 1;
+
+    return true;
+}
+
+
+#if RX_STORAGE == HR_STORAGE_DIRECT
+RX_FUNC RX_ELEM_TYPE NAME_(_extract)(RX_TYPE* rx)
+#elif RX_STORAGE == HR_STORAGE_OWNED_INDIRECT
+RX_FUNC void NAME_(_extract)(RX_TYPE* rx, RX_ELEM_TYPE* dst)
+#elif RX_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+RX_FUNC RX_ELEM_TYPE* NAME_(_extract)(RX_TYPE* rx)
+#endif
+{
+    size_t loc;
+    RX_BUCKET* bucket = NAME_(_settle)(rx, &loc);
+    RX_SLOT elem = bucket->data[loc].elem;
+
+    bucket->data[loc] = bucket->data[--bucket->used];
+    rx->_used -= 1;
+
+#if RX_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    RX_MEMCPY_ELEM((dst), (elem));
+    RX_FREE_ELEM((elem));
+#else
+    return elem;
+#endif
+}
+
+
+RX_FUNC RX_ELEM_TYPE* NAME_(_peek)(RX_TYPE* rx) {
+    size_t loc;
+    RX_BUCKET* bucket = NAME_(_settle)(rx, &loc);
+#if RX_STORAGE == HR_STORAGE_DIRECT
+    return &bucket->data[loc].elem;
+#else
+    return bucket->data[loc].elem;
+#endif
+}
+
+
+// The smallest key that may still be inserted.
+RX_FUNC RX_KEY_TYPE NAME_(_last_key)(RX_TYPE* rx) {
+    return rx->_last;
+}
+
+
+RX_FUNC size_t NAME_(_size)(RX_TYPE* rx) {
+    return rx->_used;
+}
+
+#endif
+
+
+#undef RX_ELEM_TYPE
+#undef RX_NAME
+#undef RX_KEY
+#undef RX_KEY_TYPE
+#undef RX_STORAGE
+#undef RX_MALLOC_ELEM
+#undef RX_FREE_ELEM
+#undef RX_MEMCPY_ELEM
+#undef RX_TYPE
+#undef RX_SCOPE
+#undef RX_FUNC
+#undef RX_ENTRY
+#undef RX_BUCKET
+#undef RX_BUCKETS
+#undef RX_BUCKET_OF
+#undef RX_SLOT
+#undef NAME_
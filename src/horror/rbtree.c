@@ -34,6 +34,14 @@ Walker's magnificent tutorials and red black tree library.
 #include <stdio.h>
 #include <string.h>
 
+#if defined(RB_MMAP)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "horror/macro.h"
 #include "horror/rbtree.h"
 
@@ -102,6 +110,26 @@ RB_MALLOC_NODE.
     #endif
 #endif
 
+#if defined(RB_KEY_PREFIX_TYPE) != defined(RB_KEY_PREFIX)
+    #error Error: Generic red-black tree requires RB_KEY_PREFIX_TYPE and \
+RB_KEY_PREFIX to be defined together. RB_KEY_PREFIX must be a function or \
+function-like macro which takes a pointer to an element and returns a value of \
+type RB_KEY_PREFIX_TYPE, and it must agree with RB_CMP: if the prefix of one \
+element is less than the prefix of another, RB_CMP must order them the same way.
+    #define RB_ERROR
+#elif defined(RB_KEY_PREFIX_TYPE) && RB_STORAGE == HR_STORAGE_DIRECT
+    #error Error: Generic red-black tree only supports RB_KEY_PREFIX with \
+indirect storage. Directly stored elements already live in the node.
+    #define RB_ERROR
+#endif
+
+#if defined(RB_LAZY_DELETE) && RB_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+    #error Error: Generic red-black tree does not support RB_LAZY_DELETE with \
+HR_STORAGE_BORROWED_INDIRECT. A tombstone is still compared against while the \
+tree is searched, long after the caller may have freed the element it points to.
+    #define RB_ERROR
+#endif
+
 #if !defined(RB_TRAV_NAME)
     #define RB_TRAV_NAME HR_CONCAT(RB_NAME, _trav)
 #endif
@@ -128,11 +156,45 @@ RB_MALLOC_NODE.
 #define RB_TYPE NAME_(_t)
 #define RB_NODE NAME_(_node_t)
 #define RB_TRAV HR_CONCAT(RB_TRAV_NAME, _t)
+#define RB_MAP NAME_(_map_t)
+#define RB_MAP_TRAV NAME_(_map_trav_t)
+#define RB_RECORD NAME_(_record_t)
 
 #if !defined(RB_TRAV_DEPTH_MAX)
 #define RB_TRAV_DEPTH_MAX 64
 #endif
 
+#if defined(RB_LAZY_DELETE) && !defined(RB_LAZY_DELETE_THRESHOLD)
+#define RB_LAZY_DELETE_THRESHOLD 0.5
+#endif
+
+// Operation counters. These cast away const so that lookups can count too,
+// which makes every call write to the tree: with RB_STATS on, concurrent
+// readers of one tree race on the counters and must be serialized.
+#if defined(RB_STATS)
+    #define RB_STAT(tree, field, n) (((RB_TYPE*)(tree))->stats.field += (n))
+    #define RB_STAT_ENTER(tree) (((RB_TYPE*)(tree))->stat_depth = 0)
+    #define RB_STAT_DESCEND(tree) NAME_(_stat_descend)((RB_TYPE*)(tree))
+#else
+    #define RB_STAT(tree, field, n) ((void)0)
+    #define RB_STAT_ENTER(tree) ((void)0)
+    #define RB_STAT_DESCEND(tree) ((void)0)
+#endif
+
+#define RB_CMP_COUNTED(tree, x, y) (RB_STAT(tree, comparisons, 1), RB_CMP(x, y))
+
+// Compare a node against a search key. With a key prefix, the prefix cached in
+// the node settles most comparisons without touching the element itself; only
+// ties fall through to RB_CMP.
+#if defined(RB_KEY_PREFIX_TYPE)
+    #define RB_NODE_CMP(tree, node, data, key_prefix) \
+        ((node)->prefix < (key_prefix) ? -1 : \
+         (node)->prefix > (key_prefix) ? 1 : \
+         RB_CMP_COUNTED(tree, (node)->data, (data)))
+#else
+    #define RB_NODE_CMP(tree, node, data, key_prefix) RB_CMP_COUNTED(tree, (node)->data, (data))
+#endif
+
 #if !defined(RB_ERROR)
 
 #if !defined(RB_HEADER_EXISTS)
@@ -141,6 +203,7 @@ typedef struct RB_TYPE RB_TYPE;
 typedef struct RB_TRAV RB_TRAV;
 
 RB_FUNC void NAME_(_trav_init)(RB_TRAV* trav, RB_TYPE* tree, rb_dir_t dec);
+RB_FUNC bool NAME_(_trav_split)(RB_TYPE* tree, size_t k, RB_TRAV* travs);
 RB_FUNC RB_ELEM_TYPE* NAME_(_next)(RB_TRAV* trav);
 
 RB_FUNC void NAME_(_init)(RB_TYPE* tree);
@@ -171,6 +234,34 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_pop_min)(RB_TYPE* tree);
 RB_FUNC RB_ELEM_TYPE* NAME_(_pop_max)(RB_TYPE* tree);
 #endif
 
+#if defined(RB_LAZY_DELETE)
+RB_FUNC bool NAME_(_rebuild)(RB_TYPE* tree);
+#endif
+
+#if defined(RB_STATS)
+RB_FUNC rb_stats_t NAME_(_stats)(const RB_TYPE* tree);
+RB_FUNC void NAME_(_stats_reset)(RB_TYPE* tree);
+#endif
+
+#if defined(RB_MMAP)
+typedef struct RB_MAP RB_MAP;
+typedef struct RB_MAP_TRAV RB_MAP_TRAV;
+
+RB_FUNC bool NAME_(_save)(RB_TYPE* tree, int fd);
+RB_FUNC bool NAME_(_map)(RB_MAP* map, const char* path);
+RB_FUNC void NAME_(_unmap)(RB_MAP* map);
+RB_FUNC size_t NAME_(_map_size)(const RB_MAP* map);
+
+#if RB_STORAGE == HR_STORAGE_DIRECT && !defined(RB_MEMCPY_ELEM)
+RB_FUNC const RB_ELEM_TYPE* NAME_(_map_find)(const RB_MAP* map, const RB_ELEM_TYPE data);
+#else
+RB_FUNC const RB_ELEM_TYPE* NAME_(_map_find)(const RB_MAP* map, const RB_ELEM_TYPE* data);
+#endif
+
+RB_FUNC void NAME_(_map_trav_init)(RB_MAP_TRAV* trav, const RB_MAP* map, rb_dir_t dec);
+RB_FUNC const RB_ELEM_TYPE* NAME_(_map_next)(RB_MAP_TRAV* trav);
+#endif
+
 #if defined(RB_DEBUG)
 RB_FUNC bool NAME_(_assert)(RB_TYPE* tree);
 #if defined(RB_DEBUG_DUMP)
@@ -185,7 +276,13 @@ RB_FUNC void NAME_(_dump)(RB_TYPE* tree);
 
 typedef struct RB_NODE {
     rb_color_t color;
+#if defined(RB_LAZY_DELETE)
+    bool dead;
+#endif
     struct RB_NODE* link[2];
+#if defined(RB_KEY_PREFIX_TYPE)
+    RB_KEY_PREFIX_TYPE prefix;
+#endif
 #if RB_STORAGE != HR_STORAGE_DIRECT
     RB_ELEM_TYPE* data;
 #else
@@ -196,18 +293,28 @@ typedef struct RB_NODE {
 
 struct RB_TYPE {
     size_t size;
+#if defined(RB_LAZY_DELETE)
+    size_t dead;
+#endif
+#if defined(RB_STATS)
+    rb_stats_t stats;
+    size_t stat_depth;
+#endif
     RB_NODE* root;
 };
 
 
 struct RB_TRAV {
     RB_NODE* stack[RB_TRAV_DEPTH_MAX];
+    RB_NODE* end;
     int8_t depth;
     bool dir;
 };
 
 
 RB_FUNC void NAME_(_trav_init)(RB_TRAV* trav, RB_TYPE* tree, rb_dir_t dec) {
+    trav->end = NULL;
+
     if (tree->root == NULL) {
         trav->depth = -1;
     } else {
@@ -224,17 +331,7 @@ RB_FUNC void NAME_(_trav_init)(RB_TRAV* trav, RB_TYPE* tree, rb_dir_t dec) {
 }
 
 
-RB_FUNC RB_ELEM_TYPE* NAME_(_next)(RB_TRAV* trav) {
-    if (trav->depth < 0) {
-        return NULL;
-    }
-
-#if RB_STORAGE != HR_STORAGE_DIRECT
-    RB_ELEM_TYPE* data = trav->stack[trav->depth]->data;
-#else
-    RB_ELEM_TYPE* data = &trav->stack[trav->depth]->data;
-#endif
-
+RB_FUNC void NAME_(_trav_step)(RB_TRAV* trav) {
     if (trav->stack[trav->depth]->link[trav->dir] == NULL) {
         do {
             trav->depth--;
@@ -248,17 +345,186 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_next)(RB_TRAV* trav) {
             trav->depth++;
         }
     }
+}
+
+
+RB_FUNC RB_ELEM_TYPE* NAME_(_next)(RB_TRAV* trav) {
+#if defined(RB_LAZY_DELETE)
+    // Tombstoned nodes keep their place in the tree until the next rebuild,
+    // so we have to step over them.
+    while (trav->depth >= 0 && trav->stack[trav->depth] != trav->end && trav->stack[trav->depth]->dead) {
+        NAME_(_trav_step)(trav);
+    }
+#endif
+
+    if (trav->depth < 0 || trav->stack[trav->depth] == trav->end) {
+        return NULL;
+    }
+
+#if RB_STORAGE != HR_STORAGE_DIRECT
+    RB_ELEM_TYPE* data = trav->stack[trav->depth]->data;
+#else
+    RB_ELEM_TYPE* data = &trav->stack[trav->depth]->data;
+#endif
+
+    NAME_(_trav_step)(trav);
 
     return data;
 }
 
 
+RB_FUNC size_t NAME_(_split_estimate)(RB_NODE* q) {
+    // Guess the size of a subtree from the lengths of its outer spines. In a
+    // balanced tree these track the log of the size closely enough to cut
+    // slices by.
+    size_t left = 0, right = 0;
+
+    for (RB_NODE* it = q; it != NULL; it = it->link[RB_LEFT]) {
+        left++;
+    }
+
+    for (RB_NODE* it = q; it != NULL; it = it->link[RB_RIGHT]) {
+        right++;
+    }
+
+    return q != NULL ? (size_t)1 << ((left + right) / 2) : 0;
+}
+
+
+RB_FUNC void NAME_(_split_collect)(RB_NODE* q, size_t depth, size_t levels, RB_NODE** top, size_t* before, size_t* m, size_t* weight) {
+    if (q == NULL || depth >= levels) {
+        // Everything between two consecutive top nodes hangs off a single
+        // link at the cut.
+        *weight += NAME_(_split_estimate)(q);
+        return;
+    }
+
+    NAME_(_split_collect)(q->link[RB_LEFT], depth + 1, levels, top, before, m, weight);
+
+    top[*m] = q;
+    before[*m] = *weight;
+    (*m)++;
+    *weight += 1;
+
+    NAME_(_split_collect)(q->link[RB_RIGHT], depth + 1, levels, top, before, m, weight);
+}
+
+
+RB_FUNC bool NAME_(_trav_split)(RB_TYPE* tree, size_t k, RB_TRAV* travs) {
+    if (k == 0) {
+        return true;
+    }
+
+    // The top few levels of the tree cut it into a run of subtrees. Take
+    // enough levels to have several of them per cursor, and estimate how
+    // much of the tree precedes each top node.
+    size_t levels = 1;
+    while (levels < RB_TRAV_DEPTH_MAX / 2 && ((size_t)1 << levels) < 8 * k) {
+        levels++;
+    }
+
+    size_t max_top = ((size_t)1 << levels) - 1;
+    RB_NODE** top = (RB_NODE**)malloc(max_top * sizeof(RB_NODE*));
+    size_t* before = (size_t*)malloc(max_top * sizeof(size_t));
+
+    if (top == NULL || before == NULL) {
+        free(top);
+        free(before);
+        return false;
+    }
+
+    size_t m = 0, weight = 0;
+    NAME_(_split_collect)(tree->root, 0, levels, top, before, &m, &weight);
+
+    // Cursor j starts at the top node closest to j/k of the way through the
+    // tree, and stops short of where cursor j + 1 starts. If the tree is too
+    // small to go around, some of those coincide and the cursors between
+    // them come up empty.
+    RB_NODE* start = NULL;
+    size_t i = 0;
+
+    for (size_t j = 0; j < k; j++) {
+        RB_NODE* end = NULL;
+
+        if (j + 1 < k && m > 0) {
+            size_t target = (size_t)(((double)weight * (double)(j + 1)) / (double)k);
+
+            while (i + 1 < m && before[i + 1] <= target) {
+                i++;
+            }
+
+            // The previous cursor may have rounded up past this target, so
+            // check before subtracting.
+            if (i + 1 < m && target > before[i]
+                    && target - before[i] > before[i + 1] - target) {
+                i++;
+            }
+
+            end = top[i];
+        }
+
+        RB_TRAV* trav = &travs[j];
+
+        if (start == NULL) {
+            NAME_(_trav_init)(trav, tree, RB_RIGHT);
+        } else {
+            // Rebuild the path from the root, which is exactly what the
+            // traversal stack would hold had we walked there ourselves.
+            RB_NODE* q = tree->root;
+
+            trav->dir = RB_RIGHT;
+            trav->depth = 0;
+            trav->stack[0] = q;
+
+            while (q != start) {
+                q = q->link[RB_CMP((q->data), (start->data)) < 0];
+                trav->stack[++trav->depth] = q;
+            }
+        }
+
+        trav->end = end;
+        start = end;
+    }
+
+    free(top);
+    free(before);
+
+    return true;
+}
+
+
 RB_FUNC void NAME_(_init)(RB_TYPE* tree) {
     tree->size = 0;
+#if defined(RB_LAZY_DELETE)
+    tree->dead = 0;
+#endif
+#if defined(RB_STATS)
+    NAME_(_stats_reset)(tree);
+#endif
     tree->root = NULL;
 }
 
 
+#if defined(RB_STATS)
+RB_FUNC rb_stats_t NAME_(_stats)(const RB_TYPE* tree) {
+    return tree->stats;
+}
+
+
+RB_FUNC void NAME_(_stats_reset)(RB_TYPE* tree) {
+    memset(&tree->stats, 0, sizeof(tree->stats));
+    tree->stat_depth = 0;
+}
+
+
+RB_FUNC void NAME_(_stat_descend)(RB_TYPE* tree) {
+    if (++tree->stat_depth > tree->stats.max_depth) {
+        tree->stats.max_depth = tree->stat_depth;
+    }
+}
+#endif
+
+
 RB_FUNC void NAME_(_cleanup)(RB_TYPE* tree) {
     RB_NODE *it = tree->root;
     RB_NODE *save;
@@ -278,6 +544,7 @@ RB_FUNC void NAME_(_cleanup)(RB_TYPE* tree) {
 #endif
 
             RB_FREE_NODE(it);
+            RB_STAT(tree, nodes_freed, 1);
         } else {
             /* Rotate away the left link and check again */
             save = it->link[0];
@@ -296,19 +563,46 @@ RB_FUNC bool NAME_(_is_red)(RB_NODE* node) {
 
 
 #if RB_STORAGE == HR_STORAGE_DIRECT
-RB_FUNC RB_ELEM_TYPE* NAME_(_find)(const RB_TYPE* tree, const RB_ELEM_TYPE data) {
+RB_FUNC RB_NODE* NAME_(_find_node)(const RB_TYPE* tree, const RB_ELEM_TYPE data) {
 #else
-RB_FUNC RB_ELEM_TYPE* NAME_(_find)(const RB_TYPE* tree, const RB_ELEM_TYPE* data) {
+RB_FUNC RB_NODE* NAME_(_find_node)(const RB_TYPE* tree, const RB_ELEM_TYPE* data) {
 #endif
     RB_NODE* q = tree->root;
 
-    rb_dir_t dir;
-    while (q != NULL && RB_CMP((q->data), data) != 0) {
-        dir = RB_CMP((q->data), data) < 0;
+#if defined(RB_KEY_PREFIX_TYPE)
+    const RB_KEY_PREFIX_TYPE key_prefix = RB_KEY_PREFIX(data);
+#endif
+
+    RB_STAT_ENTER(tree);
 
-        q = q->link[dir];
+    while (q != NULL) {
+        int cmp = RB_NODE_CMP(tree, q, data, key_prefix);
+
+        if (cmp == 0) {
+            break;
+        }
+
+        q = q->link[cmp < 0];
+        RB_STAT_DESCEND(tree);
     }
 
+    return q;
+}
+
+
+#if RB_STORAGE == HR_STORAGE_DIRECT
+RB_FUNC RB_ELEM_TYPE* NAME_(_find)(const RB_TYPE* tree, const RB_ELEM_TYPE data) {
+#else
+RB_FUNC RB_ELEM_TYPE* NAME_(_find)(const RB_TYPE* tree, const RB_ELEM_TYPE* data) {
+#endif
+    RB_NODE* q = NAME_(_find_node)(tree, data);
+
+#if defined(RB_LAZY_DELETE)
+    if (q != NULL && q->dead) {
+        return NULL;
+    }
+#endif
+
 #if RB_STORAGE != HR_STORAGE_DIRECT
     return q != NULL ? q->data : NULL;
 #else
@@ -342,6 +636,10 @@ RB_FUNC bool NAME_(_insert)(RB_TYPE* tree, const RB_ELEM_TYPE data) {
 #else
 RB_FUNC bool NAME_(_insert)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
 #endif
+#if defined(RB_KEY_PREFIX_TYPE)
+    const RB_KEY_PREFIX_TYPE key_prefix = RB_KEY_PREFIX(data);
+#endif
+
     if (tree->root == NULL) {
         // The tree is empty. We may attach directly to the root.
         tree->root = (RB_NODE*)(RB_MALLOC_NODE);
@@ -350,9 +648,17 @@ RB_FUNC bool NAME_(_insert)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
             return false;
         }
 
+        RB_STAT(tree, nodes_allocated, 1);
+
         tree->root->color = RB_BLACK;
+#if defined(RB_LAZY_DELETE)
+        tree->root->dead = false;
+#endif
         tree->root->link[0] = NULL;
         tree->root->link[1] = NULL;
+#if defined(RB_KEY_PREFIX_TYPE)
+        tree->root->prefix = key_prefix;
+#endif
 
 #if RB_STORAGE == HR_STORAGE_OWNED_INDIRECT
         tree->root->data = (RB_ELEM_TYPE*)(RB_MALLOC_ELEM);
@@ -379,6 +685,8 @@ RB_FUNC bool NAME_(_insert)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
 
         rb_dir_t dir = RB_LEFT, last = RB_LEFT;
 
+        RB_STAT_ENTER(tree);
+
         t = &head;
         g = p = NULL;
         q = t->link[1] = tree->root;
@@ -393,9 +701,17 @@ RB_FUNC bool NAME_(_insert)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
                     return false;
                 }
 
+                RB_STAT(tree, nodes_allocated, 1);
+
                 q->color = RB_RED;
+#if defined(RB_LAZY_DELETE)
+                q->dead = false;
+#endif
                 q->link[0] = NULL;
                 q->link[1] = NULL;
+#if defined(RB_KEY_PREFIX_TYPE)
+                q->prefix = key_prefix;
+#endif
 
 #if RB_STORAGE == HR_STORAGE_OWNED_INDIRECT
                 q->data = (RB_ELEM_TYPE*)RB_MALLOC_ELEM;
@@ -420,6 +736,7 @@ RB_FUNC bool NAME_(_insert)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
                 q->color = RB_RED;
                 q->link[0]->color = RB_BLACK;
                 q->link[1]->color = RB_BLACK;
+                RB_STAT(tree, color_flips, 1);
             }
 
             if (NAME_(_is_red)(q) && NAME_(_is_red)(p)) {
@@ -432,19 +749,39 @@ RB_FUNC bool NAME_(_insert)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
                     // If we've gone in the same direction twice, then we can
                     // fix the color violation with a single rotation.
                     t->link[g_dir] = NAME_(_single_rotate)(g, !last);
+                    RB_STAT(tree, single_rotations, 1);
                 } else {
                     // But if we've done a zig-zag, we have to rotate to get
                     // things in a straight line and then rotate again to fix
                     // the violation.
                     t->link[g_dir] = NAME_(_double_rotate)(g, !last);
+                    RB_STAT(tree, double_rotations, 1);
                 }
             }
 
-            int cmp = RB_CMP((q->data), (data));
+            int cmp = RB_NODE_CMP(tree, q, data, key_prefix);
 
             // If we have successfully inserted a node, we may break. As a side
             // effect of this logic, duplicates are silently ignored. (!!)
             if (cmp == 0) {
+#if defined(RB_LAZY_DELETE)
+                // If we ran into a tombstone for this key, bring it back to
+                // life instead of leaving the old value around.
+                if (q->dead) {
+#if RB_STORAGE == HR_STORAGE_OWNED_INDIRECT
+                    RB_MEMCPY_ELEM(q->data, data);
+#elif RB_STORAGE == HR_STORAGE_DIRECT && defined(RB_MEMCPY_ELEM)
+                    RB_MEMCPY_ELEM(&q->data, data);
+#elif RB_STORAGE == HR_STORAGE_DIRECT && !defined(RB_MEMCPY_ELEM)
+                    q->data = data;
+#elif RB_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+                    q->data = (RB_ELEM_TYPE*)data;
+#endif
+                    q->dead = false;
+                    tree->dead -= 1;
+                    tree->size += 1;
+                }
+#endif
                 break;
             }
 
@@ -463,6 +800,7 @@ RB_FUNC bool NAME_(_insert)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
             // And finally, the node in the compared direction becomes the
             // current.
             q = q->link[dir];
+            RB_STAT_DESCEND(tree);
         }
 
         // The root may have moved thanks to tree rotations. Better put it back
@@ -476,6 +814,205 @@ RB_FUNC bool NAME_(_insert)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
 }
 
 
+#if defined(RB_LAZY_DELETE)
+RB_FUNC RB_NODE* NAME_(_rebuild_rec)(RB_NODE** nodes, size_t lo, size_t hi, size_t depth, size_t red_depth) {
+    if (lo >= hi) {
+        return NULL;
+    }
+
+    size_t mid = lo + (hi - lo) / 2;
+    RB_NODE* q = nodes[mid];
+
+    // Splitting at the midpoint keeps every leaf within one level of the
+    // others. Everything above the last full level is black, and whatever
+    // hangs below it is red, so every path has the same black height.
+    q->color = depth >= red_depth ? RB_RED : RB_BLACK;
+    q->link[RB_LEFT] = NAME_(_rebuild_rec)(nodes, lo, mid, depth + 1, red_depth);
+    q->link[RB_RIGHT] = NAME_(_rebuild_rec)(nodes, mid + 1, hi, depth + 1, red_depth);
+
+    return q;
+}
+
+
+RB_FUNC bool NAME_(_rebuild)(RB_TYPE* tree) {
+    if (tree->dead == 0) {
+        return true;
+    }
+
+    RB_NODE** nodes = (RB_NODE**)malloc((tree->size + tree->dead) * sizeof(RB_NODE*));
+
+    if (nodes == NULL) {
+        return false;
+    }
+
+    // Flatten the whole tree in order first. We can't free tombstones as we
+    // go, since the traversal stack still points at nodes we've visited.
+    RB_TRAV trav;
+    NAME_(_trav_init)(&trav, tree, RB_RIGHT);
+
+    size_t n = 0;
+    while (trav.depth >= 0) {
+        nodes[n++] = trav.stack[trav.depth];
+        NAME_(_trav_step)(&trav);
+    }
+
+    size_t live = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (nodes[i]->dead) {
+#if RB_STORAGE == HR_STORAGE_OWNED_INDIRECT
+            RB_FREE_ELEM(nodes[i]->data);
+#endif
+            RB_FREE_NODE(nodes[i]);
+            RB_STAT(tree, nodes_freed, 1);
+        } else {
+            nodes[live++] = nodes[i];
+        }
+    }
+
+    // The number of completely filled levels, floor(log2(live + 1)).
+    size_t red_depth = 0;
+    while (((size_t)2 << red_depth) <= live + 1) {
+        red_depth++;
+    }
+
+    tree->root = NAME_(_rebuild_rec)(nodes, 0, live, 0, red_depth);
+    tree->dead = 0;
+
+    free(nodes);
+
+    return true;
+}
+
+
+RB_FUNC void NAME_(_check_dead)(RB_TYPE* tree) {
+    if ((double)tree->dead > RB_LAZY_DELETE_THRESHOLD * (double)(tree->size + tree->dead)) {
+        // If we can't get the memory for a rebuild, the tombstones simply
+        // stick around until the next attempt.
+        NAME_(_rebuild)(tree);
+    }
+}
+
+
+RB_FUNC void NAME_(_tombstone)(RB_TYPE* tree, RB_NODE* q) {
+    q->dead = true;
+    tree->size -= 1;
+    tree->dead += 1;
+
+    NAME_(_check_dead)(tree);
+}
+
+
+// Unlink the node at the `end` of the tree from it, pushing a red node down
+// the spine as _remove does, and return it without freeing it. Since it has
+// no child toward `end`, it's unlinked where it is, so no data has to move.
+RB_FUNC RB_NODE* NAME_(_unlink_end)(RB_TYPE* tree, rb_dir_t end) {
+    RB_NODE head = { .color = RB_BLACK };
+
+    RB_NODE* g = NULL; // The grandparent of the current node.
+    RB_NODE* p = NULL; // The parent of the current node.
+    RB_NODE* q = &head; // The current node.
+
+    rb_dir_t dir = RB_RIGHT;
+
+    q->link[RB_RIGHT] = tree->root;
+
+    RB_STAT_ENTER(tree);
+
+    while (q->link[dir] != NULL) {
+        rb_dir_t last = dir;
+
+        g = p, p = q;
+        q = q->link[dir];
+        RB_STAT_DESCEND(tree);
+        dir = end;
+
+        if (!NAME_(_is_red)(q) && !NAME_(_is_red)(q->link[dir])) {
+            if (NAME_(_is_red)(q->link[!dir])) {
+                p = p->link[last] = NAME_(_single_rotate)(q, dir);
+                RB_STAT(tree, single_rotations, 1);
+            } else {
+                RB_NODE* s = p->link[!last];
+
+                if (s != NULL) {
+                    if (!NAME_(_is_red)(s->link[0]) && !NAME_(_is_red)(s->link[1])) {
+                        p->color = RB_BLACK;
+                        s->color = RB_RED;
+                        q->color = RB_RED;
+                        RB_STAT(tree, color_flips, 1);
+                    } else {
+                        rb_dir_t g_dir = g->link[1] == p ? RB_RIGHT : RB_LEFT;
+
+                        if (NAME_(_is_red)(s->link[last])) {
+                            g->link[g_dir] = NAME_(_double_rotate)(p, last);
+                            RB_STAT(tree, double_rotations, 1);
+                        } else if (NAME_(_is_red)(s->link[!last])) {
+                            g->link[g_dir] = NAME_(_single_rotate)(p, last);
+                            RB_STAT(tree, single_rotations, 1);
+                        }
+
+                        q->color = g->link[g_dir]->color = RB_RED;
+                        g->link[g_dir]->link[0]->color = RB_BLACK;
+                        g->link[g_dir]->link[1]->color = RB_BLACK;
+                    }
+                }
+            }
+        }
+    }
+
+    p->link[p->link[1] == q] = q->link[!end];
+
+    tree->root = head.link[RB_RIGHT];
+
+    if (tree->root != NULL) {
+        tree->root->color = RB_BLACK;
+    }
+
+    return q;
+}
+
+
+// The first live node from the `end` of the tree. Tombstones in the way are
+// unlinked and freed for good, so however many pile up at one end, each is
+// only ever stepped over once, and a run of _pop_min stays O(log n) apiece.
+RB_FUNC RB_NODE* NAME_(_first_live)(RB_TYPE* tree, rb_dir_t end) {
+    while (tree->root != NULL) {
+        RB_NODE* q = tree->root;
+
+        while (q->link[end] != NULL) {
+            q = q->link[end];
+        }
+
+        if (!q->dead) {
+            return q;
+        }
+
+        NAME_(_unlink_end)(tree, end);
+#if RB_STORAGE == HR_STORAGE_OWNED_INDIRECT
+        RB_FREE_ELEM(q->data);
+#endif
+        RB_FREE_NODE(q);
+        RB_STAT(tree, nodes_freed, 1);
+        tree->dead -= 1;
+    }
+
+    return NULL;
+}
+
+
+#if RB_STORAGE == HR_STORAGE_DIRECT
+RB_FUNC void NAME_(_remove)(RB_TYPE* tree, const RB_ELEM_TYPE data) {
+#else
+RB_FUNC void NAME_(_remove)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
+#endif
+    RB_NODE* q = NAME_(_find_node)(tree, data);
+
+    if (q != NULL && !q->dead) {
+        NAME_(_tombstone)(tree, q);
+    }
+}
+
+#else
+
 #if RB_STORAGE == HR_STORAGE_DIRECT
 RB_FUNC void NAME_(_remove)(RB_TYPE* tree, const RB_ELEM_TYPE data) {
 #else
@@ -492,10 +1029,16 @@ RB_FUNC void NAME_(_remove)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
 
         rb_dir_t dir = RB_RIGHT;
 
+#if defined(RB_KEY_PREFIX_TYPE)
+        const RB_KEY_PREFIX_TYPE key_prefix = RB_KEY_PREFIX(data);
+#endif
+
         q = &head;
         g = p = NULL;
         q->link[1] = tree->root;
 
+        RB_STAT_ENTER(tree);
+
         // While we search, we push a red node down the tree while maintaining
         // invariants so that the node we eventually remove is a red one.
         while (q->link[dir] != NULL) {
@@ -505,11 +1048,14 @@ RB_FUNC void NAME_(_remove)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
             // Move our iterators down a notch.
             g = p, p = q;
             q = q->link[dir];
-            dir = RB_CMP((q->data), (data)) < 0;
+            RB_STAT_DESCEND(tree);
+
+            int cmp = RB_NODE_CMP(tree, q, data, key_prefix);
+            dir = cmp < 0;
 
             // If we found the node, save it for later. We have violations to
             // fix.
-            if (RB_CMP((q->data), (data)) == 0) {
+            if (cmp == 0) {
                 f = q;
             }
 
@@ -522,6 +1068,7 @@ RB_FUNC void NAME_(_remove)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
                     // We must update our parent iterator. This here works since
                     // last tells us which child of p q is. Neat.
                     p = p->link[last] = NAME_(_single_rotate)(q, dir);
+                    RB_STAT(tree, single_rotations, 1);
                 } else if (!NAME_(_is_red)(q->link[!dir])) {
                     // This is the sibling of our current node.
                     RB_NODE* s = p->link[!last];
@@ -535,13 +1082,16 @@ RB_FUNC void NAME_(_remove)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
                             p->color = RB_BLACK;
                             s->color = RB_RED;
                             q->color = RB_RED;
+                            RB_STAT(tree, color_flips, 1);
                         } else {
                             rb_dir_t g_dir = g->link[1] == p ? RB_RIGHT : RB_LEFT;
 
                             if (NAME_(_is_red)(s->link[last])) {
                                 g->link[g_dir] = NAME_(_double_rotate)(p, last);
+                                RB_STAT(tree, double_rotations, 1);
                             } else if (NAME_(_is_red)(s->link[!last])) {
                                 g->link[g_dir] = NAME_(_single_rotate)(p, last);
+                                RB_STAT(tree, single_rotations, 1);
                             }
 
                             q->color = g->link[g_dir]->color = RB_RED;
@@ -564,8 +1114,13 @@ RB_FUNC void NAME_(_remove)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
             f->data = q->data;
 #endif
 
+#if defined(RB_KEY_PREFIX_TYPE)
+            f->prefix = q->prefix;
+#endif
+
             p->link[p->link[1] == q] = q->link[q->link[0] == NULL];
             RB_FREE_NODE(q);
+            RB_STAT(tree, nodes_freed, 1);
 
             tree->size -= 1;
         }
@@ -578,9 +1133,100 @@ RB_FUNC void NAME_(_remove)(RB_TYPE* tree, const RB_ELEM_TYPE* data) {
     }
 }
 
+#endif
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wuninitialized"
 
+#if defined(RB_LAZY_DELETE)
+
+#if RB_STORAGE == HR_STORAGE_DIRECT && !defined(RB_MEMCPY_ELEM)
+RB_FUNC RB_ELEM_TYPE NAME_(_pop_min)(RB_TYPE* tree)
+#else
+RB_FUNC void NAME_(_pop_min)(RB_TYPE* tree, RB_ELEM_TYPE* dst)
+#endif
+{
+    RB_NODE* q = NAME_(_first_live)(tree, RB_LEFT);
+
+    // A node at the end of the tree is cheap to take out for real, so popping
+    // never leaves a tombstone behind.
+    if (q != NULL) {
+        NAME_(_unlink_end)(tree, RB_LEFT);
+        tree->size -= 1;
+    }
+
+#if RB_STORAGE == HR_STORAGE_DIRECT && !defined(RB_MEMCPY_ELEM)
+    RB_ELEM_TYPE ret;
+    if (q != NULL) {
+        ret = q->data;
+    }
+#elif RB_STORAGE == HR_STORAGE_DIRECT && defined(RB_MEMCPY_ELEM)
+    if (q != NULL) {
+        RB_MEMCPY_ELEM(dst, &q->data);
+    }
+#elif RB_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    if (q != NULL) {
+        RB_MEMCPY_ELEM(dst, q->data);
+        RB_FREE_ELEM(q->data);
+    }
+#endif
+
+    if (q != NULL) {
+        RB_FREE_NODE(q);
+        RB_STAT(tree, nodes_freed, 1);
+        NAME_(_check_dead)(tree);
+    }
+
+#if RB_STORAGE == HR_STORAGE_DIRECT && !defined(RB_MEMCPY_ELEM)
+    return ret;
+#endif
+}
+
+
+#if RB_STORAGE == HR_STORAGE_DIRECT && !defined(RB_MEMCPY_ELEM)
+RB_FUNC RB_ELEM_TYPE NAME_(_pop_max)(RB_TYPE* tree)
+#else
+RB_FUNC void NAME_(_pop_max)(RB_TYPE* tree, RB_ELEM_TYPE* dst)
+#endif
+{
+    RB_NODE* q = NAME_(_first_live)(tree, RB_RIGHT);
+
+    // A node at the end of the tree is cheap to take out for real, so popping
+    // never leaves a tombstone behind.
+    if (q != NULL) {
+        NAME_(_unlink_end)(tree, RB_RIGHT);
+        tree->size -= 1;
+    }
+
+#if RB_STORAGE == HR_STORAGE_DIRECT && !defined(RB_MEMCPY_ELEM)
+    RB_ELEM_TYPE ret;
+    if (q != NULL) {
+        ret = q->data;
+    }
+#elif RB_STORAGE == HR_STORAGE_DIRECT && defined(RB_MEMCPY_ELEM)
+    if (q != NULL) {
+        RB_MEMCPY_ELEM(dst, &q->data);
+    }
+#elif RB_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    if (q != NULL) {
+        RB_MEMCPY_ELEM(dst, q->data);
+        RB_FREE_ELEM(q->data);
+    }
+#endif
+
+    if (q != NULL) {
+        RB_FREE_NODE(q);
+        RB_STAT(tree, nodes_freed, 1);
+        NAME_(_check_dead)(tree);
+    }
+
+#if RB_STORAGE == HR_STORAGE_DIRECT && !defined(RB_MEMCPY_ELEM)
+    return ret;
+#endif
+}
+
+#else
+
 #if RB_STORAGE == HR_STORAGE_DIRECT && !defined(RB_MEMCPY_ELEM)
 RB_FUNC RB_ELEM_TYPE NAME_(_pop_min)(RB_TYPE* tree)
 #elif (RB_STORAGE == HR_STORAGE_DIRECT && defined(RB_MEMCPY_ELEM)) || RB_STORAGE == HR_STORAGE_OWNED_INDIRECT
@@ -610,6 +1256,8 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_pop_min)(RB_TYPE* tree)
         g = p = NULL;
         q->link[1] = tree->root;
 
+        RB_STAT_ENTER(tree);
+
         // While we search, we push a red node down the tree while maintaining
         // invariants so that the node we eventually remove is a red one.
         while (q->link[dir] != NULL) {
@@ -619,6 +1267,7 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_pop_min)(RB_TYPE* tree)
             // Move our iterators down a notch.
             g = p, p = q;
             q = q->link[dir];
+            RB_STAT_DESCEND(tree);
             dir = RB_LEFT;
 
             // If we found the node, save it for later. We have violations to
@@ -636,6 +1285,7 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_pop_min)(RB_TYPE* tree)
                     // We must update our parent iterator. This here works since
                     // last tells us which child of p q is. Neat.
                     p = p->link[last] = NAME_(_single_rotate)(q, dir);
+                    RB_STAT(tree, single_rotations, 1);
                 } else if (!NAME_(_is_red)(q->link[!dir])) {
                     // This is the sibling of our current node.
                     RB_NODE* s = p->link[!last];
@@ -649,13 +1299,16 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_pop_min)(RB_TYPE* tree)
                             p->color = RB_BLACK;
                             s->color = RB_RED;
                             q->color = RB_RED;
+                            RB_STAT(tree, color_flips, 1);
                         } else {
                             rb_dir_t g_dir = g->link[1] == p ? RB_RIGHT : RB_LEFT;
 
                             if (NAME_(_is_red)(s->link[last])) {
                                 g->link[g_dir] = NAME_(_double_rotate)(p, last);
+                                RB_STAT(tree, double_rotations, 1);
                             } else if (NAME_(_is_red)(s->link[!last])) {
                                 g->link[g_dir] = NAME_(_single_rotate)(p, last);
+                                RB_STAT(tree, single_rotations, 1);
                             }
 
                             q->color = g->link[g_dir]->color = RB_RED;
@@ -683,8 +1336,13 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_pop_min)(RB_TYPE* tree)
             f->data = q->data;
 #endif
 
+#if defined(RB_KEY_PREFIX_TYPE)
+            f->prefix = q->prefix;
+#endif
+
             p->link[p->link[1] == q] = q->link[q->link[0] == NULL];
             RB_FREE_NODE(q);
+            RB_STAT(tree, nodes_freed, 1);
 
             tree->size -= 1;
         }
@@ -731,6 +1389,8 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_pop_max)(RB_TYPE* tree)
         g = p = NULL;
         q->link[1] = tree->root;
 
+        RB_STAT_ENTER(tree);
+
         // While we search, we push a red node down the tree while maintaining
         // invariants so that the node we eventually remove is a red one.
         while (q->link[dir] != NULL) {
@@ -740,6 +1400,7 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_pop_max)(RB_TYPE* tree)
             // Move our iterators down a notch.
             g = p, p = q;
             q = q->link[dir];
+            RB_STAT_DESCEND(tree);
             dir = RB_RIGHT;
 
             // If we found the node, save it for later. We have violations to
@@ -757,6 +1418,7 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_pop_max)(RB_TYPE* tree)
                     // We must update our parent iterator. This here works since
                     // last tells us which child of p q is. Neat.
                     p = p->link[last] = NAME_(_single_rotate)(q, dir);
+                    RB_STAT(tree, single_rotations, 1);
                 } else if (!NAME_(_is_red)(q->link[!dir])) {
                     // This is the sibling of our current node.
                     RB_NODE* s = p->link[!last];
@@ -770,13 +1432,16 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_pop_max)(RB_TYPE* tree)
                             p->color = RB_BLACK;
                             s->color = RB_RED;
                             q->color = RB_RED;
+                            RB_STAT(tree, color_flips, 1);
                         } else {
                             rb_dir_t g_dir = g->link[1] == p ? RB_RIGHT : RB_LEFT;
 
                             if (NAME_(_is_red)(s->link[last])) {
                                 g->link[g_dir] = NAME_(_double_rotate)(p, last);
+                                RB_STAT(tree, double_rotations, 1);
                             } else if (NAME_(_is_red)(s->link[!last])) {
                                 g->link[g_dir] = NAME_(_single_rotate)(p, last);
+                                RB_STAT(tree, single_rotations, 1);
                             }
 
                             q->color = g->link[g_dir]->color = RB_RED;
@@ -804,8 +1469,13 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_pop_max)(RB_TYPE* tree)
             f->data = q->data;
 #endif
 
+#if defined(RB_KEY_PREFIX_TYPE)
+            f->prefix = q->prefix;
+#endif
+
             p->link[p->link[1] == q] = q->link[q->link[0] == NULL];
             RB_FREE_NODE(q);
+            RB_STAT(tree, nodes_freed, 1);
 
             tree->size -= 1;
         }
@@ -822,6 +1492,8 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_pop_max)(RB_TYPE* tree)
 #endif
 }
 
+#endif
+
 #pragma GCC diagnostic pop
 
 
@@ -831,6 +1503,12 @@ RB_FUNC size_t NAME_(_size)(RB_TYPE* tree) {
 
 
 RB_FUNC RB_ELEM_TYPE* NAME_(_min)(RB_TYPE* tree) {
+#if defined(RB_LAZY_DELETE)
+    RB_NODE* q = NAME_(_first_live)(tree, RB_LEFT);
+    if (q == NULL) {
+        return NULL;
+    }
+#else
     RB_NODE* q = tree->root;
     if (q == NULL) {
         return NULL;
@@ -839,6 +1517,7 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_min)(RB_TYPE* tree) {
     while (q->link[RB_LEFT] != NULL) {
         q = q->link[RB_LEFT];
     }
+#endif
 
 #if RB_STORAGE != HR_STORAGE_DIRECT
     return q->data;
@@ -849,6 +1528,12 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_min)(RB_TYPE* tree) {
 
 
 RB_FUNC RB_ELEM_TYPE* NAME_(_max)(RB_TYPE* tree) {
+#if defined(RB_LAZY_DELETE)
+    RB_NODE* q = NAME_(_first_live)(tree, RB_RIGHT);
+    if (q == NULL) {
+        return NULL;
+    }
+#else
     RB_NODE* q = tree->root;
     if (q == NULL) {
         return NULL;
@@ -857,6 +1542,7 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_max)(RB_TYPE* tree) {
     while (q->link[RB_RIGHT] != NULL) {
         q = q->link[RB_RIGHT];
     }
+#endif
 
 #if RB_STORAGE != HR_STORAGE_DIRECT
     return q->data;
@@ -866,6 +1552,318 @@ RB_FUNC RB_ELEM_TYPE* NAME_(_max)(RB_TYPE* tree) {
 }
 
 
+#if defined(RB_MMAP)
+typedef struct RB_RECORD {
+    uint32_t link[2];
+    RB_ELEM_TYPE data;
+} RB_RECORD;
+
+
+struct RB_MAP {
+    void* base;
+    size_t length;
+    size_t size;
+    uint32_t root;
+    const RB_RECORD* nodes;
+};
+
+
+struct RB_MAP_TRAV {
+    const RB_RECORD* nodes;
+    uint32_t stack[RB_TRAV_DEPTH_MAX];
+    int8_t depth;
+    bool dir;
+};
+
+
+#if RB_STORAGE == HR_STORAGE_DIRECT
+#define RB_RECORD_DATA(r) ((r)->data)
+#else
+#define RB_RECORD_DATA(r) ((RB_ELEM_TYPE*)&(r)->data)
+#endif
+
+
+RB_FUNC bool NAME_(_write_all)(int fd, const void* buf, size_t len) {
+    const char* p = (const char*)buf;
+
+    while (len > 0) {
+        ssize_t written = write(fd, p, len);
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return false;
+        }
+
+        p += written;
+        len -= (size_t)written;
+    }
+
+    return true;
+}
+
+
+RB_FUNC bool NAME_(_save)(RB_TYPE* tree, int fd) {
+#if defined(RB_LAZY_DELETE)
+    // Tombstones have no place in the image, so purge them first.
+    if (!NAME_(_rebuild)(tree)) {
+        return false;
+    }
+#endif
+
+    if (tree->size >= RB_IMAGE_NIL) {
+        return false;
+    }
+
+    rb_image_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RB_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = RB_IMAGE_VERSION;
+    header.elem_size = sizeof(RB_ELEM_TYPE);
+    header.record_size = sizeof(RB_RECORD);
+    header.root = tree->root != NULL ? 0 : RB_IMAGE_NIL;
+    header.count = tree->size;
+
+    if (!NAME_(_write_all)(fd, &header, sizeof(header))) {
+        return false;
+    }
+
+    if (tree->root == NULL) {
+        return true;
+    }
+
+    // Nodes are numbered in breadth-first order, which keeps the top levels
+    // of the tree packed together at the front of the image. A node's index
+    // is its position in the queue, so the children's indices are known as
+    // soon as they're queued.
+    RB_NODE** queue = (RB_NODE**)malloc(tree->size * sizeof(RB_NODE*));
+
+    size_t batch = 65536 / sizeof(RB_RECORD) + 1;
+    RB_RECORD* buf = (RB_RECORD*)malloc(batch * sizeof(RB_RECORD));
+
+    if (queue == NULL || buf == NULL) {
+        free(queue);
+        free(buf);
+        return false;
+    }
+
+    bool ok = true;
+    size_t head = 0, tail = 0, used = 0;
+    queue[tail++] = tree->root;
+
+    while (head < tail) {
+        RB_NODE* q = queue[head++];
+        RB_RECORD* r = &buf[used++];
+
+        memset(r, 0, sizeof(RB_RECORD));
+
+        for (int dir = RB_LEFT; dir <= RB_RIGHT; dir++) {
+            if (q->link[dir] != NULL) {
+                r->link[dir] = (uint32_t)tail;
+                queue[tail++] = q->link[dir];
+            } else {
+                r->link[dir] = RB_IMAGE_NIL;
+            }
+        }
+
+#if RB_STORAGE == HR_STORAGE_OWNED_INDIRECT
+        RB_MEMCPY_ELEM(&r->data, q->data);
+#elif RB_STORAGE == HR_STORAGE_DIRECT && defined(RB_MEMCPY_ELEM)
+        RB_MEMCPY_ELEM(&r->data, &q->data);
+#elif RB_STORAGE == HR_STORAGE_DIRECT && !defined(RB_MEMCPY_ELEM)
+        r->data = q->data;
+#elif RB_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+        r->data = *q->data;
+#endif
+
+        if (used == batch || head == tail) {
+            if (!NAME_(_write_all)(fd, buf, used * sizeof(RB_RECORD))) {
+                ok = false;
+                break;
+            }
+
+            used = 0;
+        }
+    }
+
+    free(queue);
+    free(buf);
+
+    return ok;
+}
+
+
+// _save numbers the nodes in breadth-first order, so reading the links of
+// each record in turn, they have to count up 1, 2, 3 and so on from the root
+// at 0, and every node has to be linked to before its own record comes up.
+// Anything else, such as a link past the end of the image or back up the tree,
+// is a corrupted image, which would send _map_find or a traversal outside the
+// mapping or around in circles. Tracking where each level ends also bounds
+// the depth, so that traversal can't overflow its stack.
+RB_FUNC bool NAME_(_map_check)(const RB_RECORD* nodes, uint64_t count) {
+    uint64_t next = 1, level_end = 1;
+    size_t depth = 1;
+
+    for (uint64_t i = 0; i < count; i++) {
+        if (i >= next) {
+            return false;
+        }
+
+        if (i == level_end) {
+            level_end = next;
+
+            if (++depth > RB_TRAV_DEPTH_MAX) {
+                return false;
+            }
+        }
+
+        for (int dir = RB_LEFT; dir <= RB_RIGHT; dir++) {
+            uint32_t link = nodes[i].link[dir];
+
+            if (link != RB_IMAGE_NIL) {
+                if (link != next) {
+                    return false;
+                }
+
+                next++;
+            }
+        }
+    }
+
+    return next == count;
+}
+
+
+RB_FUNC bool NAME_(_map)(RB_MAP* map, const char* path) {
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(rb_image_header_t)) {
+        close(fd);
+        return false;
+    }
+
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    // The mapping keeps its own reference to the file.
+    close(fd);
+
+    if (base == MAP_FAILED) {
+        return false;
+    }
+
+    const rb_image_header_t* header = (const rb_image_header_t*)base;
+
+    if (memcmp(header->magic, RB_IMAGE_MAGIC, sizeof(header->magic)) != 0
+            || header->version != RB_IMAGE_VERSION
+            || header->elem_size != sizeof(RB_ELEM_TYPE)
+            || header->record_size != sizeof(RB_RECORD)
+            || header->count >= RB_IMAGE_NIL
+            || (size_t)st.st_size != sizeof(rb_image_header_t) + header->count * sizeof(RB_RECORD)
+            || (header->count > 0 && header->root != 0)) {
+        munmap(base, (size_t)st.st_size);
+        return false;
+    }
+
+    if (header->count > 0 && !NAME_(_map_check)((const RB_RECORD*)((const char*)base + sizeof(rb_image_header_t)), header->count)) {
+        munmap(base, (size_t)st.st_size);
+        return false;
+    }
+
+    map->base = base;
+    map->length = (size_t)st.st_size;
+    map->size = header->count;
+    map->root = header->count > 0 ? header->root : RB_IMAGE_NIL;
+    map->nodes = (const RB_RECORD*)((const char*)base + sizeof(rb_image_header_t));
+
+    return true;
+}
+
+
+RB_FUNC void NAME_(_unmap)(RB_MAP* map) {
+    munmap(map->base, map->length);
+}
+
+
+RB_FUNC size_t NAME_(_map_size)(const RB_MAP* map) {
+    return map->size;
+}
+
+
+#if RB_STORAGE == HR_STORAGE_DIRECT && !defined(RB_MEMCPY_ELEM)
+RB_FUNC const RB_ELEM_TYPE* NAME_(_map_find)(const RB_MAP* map, const RB_ELEM_TYPE data) {
+#else
+RB_FUNC const RB_ELEM_TYPE* NAME_(_map_find)(const RB_MAP* map, const RB_ELEM_TYPE* data) {
+#endif
+    uint32_t i = map->root;
+
+    while (i != RB_IMAGE_NIL) {
+        const RB_RECORD* r = &map->nodes[i];
+        int cmp = RB_CMP(RB_RECORD_DATA(r), data);
+
+        if (cmp == 0) {
+            return &r->data;
+        }
+
+        i = r->link[cmp < 0];
+    }
+
+    return NULL;
+}
+
+
+RB_FUNC void NAME_(_map_trav_init)(RB_MAP_TRAV* trav, const RB_MAP* map, rb_dir_t dec) {
+    trav->nodes = map->nodes;
+
+    if (map->root == RB_IMAGE_NIL) {
+        trav->depth = -1;
+    } else {
+        trav->depth = 0;
+        trav->stack[0] = map->root;
+
+        trav->dir = dec;
+
+        while (trav->nodes[trav->stack[trav->depth]].link[!dec] != RB_IMAGE_NIL) {
+            trav->stack[trav->depth + 1] = trav->nodes[trav->stack[trav->depth]].link[!dec];
+            trav->depth++;
+        }
+    }
+}
+
+
+RB_FUNC const RB_ELEM_TYPE* NAME_(_map_next)(RB_MAP_TRAV* trav) {
+    if (trav->depth < 0) {
+        return NULL;
+    }
+
+    const RB_RECORD* nodes = trav->nodes;
+    const RB_ELEM_TYPE* data = &nodes[trav->stack[trav->depth]].data;
+
+    if (nodes[trav->stack[trav->depth]].link[trav->dir] == RB_IMAGE_NIL) {
+        do {
+            trav->depth--;
+        } while (trav->depth >= 0 && nodes[trav->stack[trav->depth]].link[trav->dir] == trav->stack[trav->depth + 1]);
+    } else {
+        trav->stack[trav->depth + 1] = nodes[trav->stack[trav->depth]].link[trav->dir];
+        trav->depth++;
+
+        while (nodes[trav->stack[trav->depth]].link[!trav->dir] != RB_IMAGE_NIL) {
+            trav->stack[trav->depth + 1] = nodes[trav->stack[trav->depth]].link[!trav->dir];
+            trav->depth++;
+        }
+    }
+
+    return data;
+}
+#endif
+
+
 #if defined(RB_DEBUG)
 RB_FUNC bool NAME_(_assert_rec)(RB_TYPE* tree, RB_NODE *root)
 {
@@ -919,6 +1917,15 @@ RB_FUNC bool NAME_(_assert_rec)(RB_TYPE* tree, RB_NODE *root)
             return 0;
         }
 
+#if defined(RB_KEY_PREFIX_TYPE)
+        /* Stale key prefix */
+        if (root->prefix != RB_KEY_PREFIX(root->data))
+        {
+            fprintf(stderr, "Key prefix violation\n");
+            return 0;
+        }
+#endif
+
         /* Black height mismatch */
         if (lh != 0 && rh != 0 && lh != rh)
         {
@@ -947,7 +1954,13 @@ RB_FUNC bool NAME_(_assert)(RB_TYPE* tree) {
 RB_FUNC void NAME_(_dump_rec)(RB_NODE* root) {
     if (root->link[RB_LEFT] != NULL) NAME_(_dump_rec)(root->link[RB_LEFT]);
 
+#if defined(RB_LAZY_DELETE)
+    if (!root->dead) {
+        RB_DEBUG_DUMP(root->data);
+    }
+#else
     RB_DEBUG_DUMP(root->data);
+#endif
 
     if (root->link[RB_RIGHT] != NULL) NAME_(_dump_rec)(root->link[RB_RIGHT]);
 }
@@ -975,11 +1988,26 @@ RB_FUNC void NAME_(_dump)(RB_TYPE* tree) {
 #undef RB_TYPE
 #undef RB_NODE
 #undef RB_TRAV
+#undef RB_MAP
+#undef RB_MAP_TRAV
+#undef RB_RECORD
+#undef RB_RECORD_DATA
+#undef RB_MMAP
+#undef RB_STATS
+#undef RB_STAT
+#undef RB_STAT_ENTER
+#undef RB_STAT_DESCEND
+#undef RB_CMP_COUNTED
+#undef RB_NODE_CMP
+#undef RB_KEY_PREFIX_TYPE
+#undef RB_KEY_PREFIX
 #undef RB_SCOPE
 #undef RB_FUNC
 #undef NAME_
 #undef RB_TRAV_DEPTH_MAX
 #undef RB_DEBUG
 #undef RB_DEBUG_DUMP
+#undef RB_LAZY_DELETE
+#undef RB_LAZY_DELETE_THRESHOLD
 #undef RB_ERROR
 #undef RB_HEADER_EXISTS
@@ -30,7 +30,37 @@ Walker's magnificent tutorials and red black tree library.
 #if !defined(HR_RBTREE_H)
 #define HR_RBTREE_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 typedef enum { RB_LEFT = 0, RB_RIGHT = 1 } rb_dir_t;
 typedef enum { RB_BLACK = 0, RB_RED = 1 } rb_color_t;
 
+// Operation counters kept by trees generated with `RB_STATS`.
+typedef struct {
+    uint64_t comparisons;
+    uint64_t single_rotations;
+    uint64_t double_rotations;
+    uint64_t color_flips;
+    uint64_t nodes_allocated;
+    uint64_t nodes_freed;
+    size_t max_depth;
+} rb_stats_t;
+
+// Header of the image written by `<RB_NAME>_save`. The nodes follow it as an
+// array of records whose links are indices into that array, so the image can
+// be mapped anywhere. Everything is stored in native byte order.
+#define RB_IMAGE_MAGIC "HRRBTREE"
+#define RB_IMAGE_VERSION 1
+#define RB_IMAGE_NIL UINT32_MAX
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t elem_size;
+    uint32_t record_size;
+    uint32_t root;
+    uint64_t count;
+} rb_image_header_t;
+
 #endif
@@ -0,0 +1,669 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "horror/macro.h"
+
+
+#if !defined(TW_ELEM_TYPE)
+    #error Error: Generic timer wheel requires TW_ELEM_TYPE to be defined.
+    #define TW_ELEM_TYPE char // For purposes of testing.
+#endif
+
+#if !defined(TW_NAME)
+    #error Error: Generic timer wheel requires TW_NAME to be defined. It \
+can not use the type, since it might be a pointer.
+    #define TW_NAME tw_char // For purposes of testing.
+#endif
+
+#if !defined(TW_TIME_TYPE)
+    #define TW_TIME_TYPE uint64_t
+#endif
+
+#if !defined(TW_LEVEL_BITS)
+    #define TW_LEVEL_BITS 8
+#endif
+
+#if !defined(TW_LEVELS)
+    #define TW_LEVELS 4
+#endif
+
+#if TW_LEVEL_BITS < 1 || TW_LEVELS < 1 || TW_LEVEL_BITS * TW_LEVELS >= 64
+    #error Error: Generic timer wheel requires TW_LEVEL_BITS and TW_LEVELS to \
+be positive, and the range of the wheel, TW_LEVEL_BITS * TW_LEVELS bits, to \
+be narrower than 64 bits, leaving room for far-future deadlines.
+#endif
+
+#if TW_STORAGE == HR_STORAGE_OWNED_INDIRECT && (!defined(TW_MALLOC_ELEM) || !defined(TW_FREE_ELEM))
+    #if defined(TW_MALLOC_ELEM)
+        #error Error: Generic timer wheel is given a custom TW_MALLOC_ELEM, but \
+not a custom TW_FREE_ELEM! This is dangerous, potentially even more dangerous than \
+deciding to use this library in the first place. Please define a custom TW_FREE_ELEM.
+    #endif
+
+    #if defined(TW_FREE_ELEM)
+        #error Error: Generic timer wheel is given a custom TW_FREE_ELEM, but \
+not a custom TW_MALLOC_ELEM! This is dangerous, potentially even more dangerous \
+than deciding to use this library in the first place. Please define a custom \
+TW_MALLOC_ELEM.
+    #endif
+
+    #define TW_MALLOC_ELEM (malloc(sizeof(TW_ELEM_TYPE)))
+    #define TW_FREE_ELEM(ptr) (free(ptr))
+#endif
+
+#if TW_STORAGE == HR_STORAGE_OWNED_INDIRECT && !defined(TW_MEMCPY_ELEM)
+    #define TW_MEMCPY_ELEM(dst, src) (memcpy(dst, src, sizeof(TW_ELEM_TYPE)))
+#endif
+
+#if !defined(TW_TYPE)
+    #define TW_TYPE HR_CONCAT(TW_NAME, _t)
+#endif
+
+#if !defined(TW_POOL_CHUNK)
+    #define TW_POOL_CHUNK 256
+#endif
+
+
+#if TW_SCOPE == HR_SCOPE_NONE
+    #define TW_FUNC
+#elif TW_SCOPE == HR_SCOPE_STATIC
+    #define TW_FUNC static
+#elif TW_SCOPE == HR_SCOPE_STATIC_INLINE
+    #define TW_FUNC static inline
+#elif TW_SCOPE == HR_SCOPE_EXTERN_INLINE
+    #define TW_FUNC extern inline
+#else
+    #error Error: Generic timer wheel requires TW_SCOPE to be defined.
+    #define TW_FUNC // For testing purposes.
+#endif
+
+#if !defined(TW_STORAGE)
+    #error Error: Generic timer wheel requires TW_STORAGE to be defined.
+    #define TW_STORAGE HR_STORAGE_DIRECT // For testing purposes.
+#endif
+
+#define TW_TIMER HR_CONCAT(TW_NAME, _timer_t)
+#define TW_CHUNK HR_CONCAT(TW_NAME, _chunk_t)
+#define TW_FAR HR_CONCAT(TW_NAME, _far)
+
+#define TW_SLOTS ((size_t)1 << TW_LEVEL_BITS)
+#define TW_WORDS ((TW_SLOTS + 63) / 64)
+
+// Ticks below the given level's slots, and below the whole wheel. A wheel
+// may span all of TW_TIME_TYPE's bits, as 8x4 levels do a uint32_t, in which
+// case the mask saturates rather than shifting by the type's full width.
+#define TW_TIME_BITS (sizeof(TW_TIME_TYPE) * CHAR_BIT)
+#define TW_LOW_MASK(level) ((TW_TIME_TYPE)(TW_LEVEL_BITS * (level) >= TW_TIME_BITS \
+    ? ~(TW_TIME_TYPE)0 \
+    : ((TW_TIME_TYPE)1 << (TW_LEVEL_BITS * (level) % TW_TIME_BITS)) - 1))
+#define TW_RANGE_MASK TW_LOW_MASK(TW_LEVELS)
+
+// Where a timer is: one of the wheel's slots, numbered level by level, or
+// one of these.
+#define TW_IN_DUE (TW_LEVELS * TW_SLOTS)
+#define TW_IN_FAR (TW_IN_DUE + 1)
+#define TW_IN_FREE (TW_IN_DUE + 2)
+
+
+typedef struct TW_TYPE TW_TYPE;
+typedef struct TW_TIMER TW_TIMER;
+
+
+#if TW_SCOPE != HR_SCOPE_HEADER && TW_SCOPE != HR_SCOPE_EXTERN_INLINE
+
+// Timers are chained into doubly linked lists, one per slot plus the list of
+// timers that are due. Those too far out for the wheel wait in a heap instead.
+struct TW_TIMER {
+    TW_TIMER* next;
+    TW_TIMER* prev;
+    TW_TIME_TYPE deadline;
+    size_t where;
+    size_t handle;
+#if TW_STORAGE == HR_STORAGE_DIRECT
+    TW_ELEM_TYPE data;
+#else
+    TW_ELEM_TYPE* data;
+#endif
+};
+
+
+#define HP_SCOPE TW_SCOPE
+#define HP_STORAGE HR_STORAGE_BORROWED_INDIRECT
+#define HP_ELEM_TYPE TW_TIMER
+#define HP_NAME TW_FAR
+#define HP_CMP(x, y) ((x)->deadline < (y)->deadline)
+#define HP_INDEXED
+#include "horror/heap.c"
+
+#endif
+
+#define NAME_(n) HR_CONCAT(TW_NAME, n)
+
+
+TW_FUNC bool NAME_(_init)(TW_TYPE* tw, TW_TIME_TYPE now);
+TW_FUNC void NAME_(_cleanup)(TW_TYPE* tw);
+
+#if TW_STORAGE == HR_STORAGE_DIRECT
+TW_FUNC TW_TIMER* NAME_(_arm)(TW_TYPE* tw, TW_TIME_TYPE deadline, TW_ELEM_TYPE elem);
+TW_FUNC size_t NAME_(_advance)(TW_TYPE* tw, TW_TIME_TYPE now, TW_ELEM_TYPE* out, size_t n);
+#elif TW_STORAGE == HR_STORAGE_OWNED_INDIRECT
+TW_FUNC TW_TIMER* NAME_(_arm)(TW_TYPE* tw, TW_TIME_TYPE deadline, TW_ELEM_TYPE* elem);
+TW_FUNC size_t NAME_(_advance)(TW_TYPE* tw, TW_TIME_TYPE now, TW_ELEM_TYPE* out, size_t n);
+#elif TW_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+TW_FUNC TW_TIMER* NAME_(_arm)(TW_TYPE* tw, TW_TIME_TYPE deadline, TW_ELEM_TYPE* elem);
+TW_FUNC size_t NAME_(_advance)(TW_TYPE* tw, TW_TIME_TYPE now, TW_ELEM_TYPE** out, size_t n);
+#endif
+
+TW_FUNC bool NAME_(_rearm)(TW_TYPE* tw, TW_TIMER* timer, TW_TIME_TYPE deadline);
+TW_FUNC void NAME_(_cancel)(TW_TYPE* tw, TW_TIMER* timer);
+TW_FUNC TW_ELEM_TYPE* NAME_(_get)(TW_TIMER* timer);
+TW_FUNC TW_TIME_TYPE NAME_(_deadline)(TW_TIMER* timer);
+TW_FUNC TW_TIME_TYPE NAME_(_now)(TW_TYPE* tw);
+TW_FUNC size_t NAME_(_size)(TW_TYPE* tw);
+
+#if TW_SCOPE != HR_SCOPE_HEADER && TW_SCOPE != HR_SCOPE_EXTERN_INLINE
+
+typedef struct TW_CHUNK {
+    struct TW_CHUNK* next;
+    TW_TIMER timers[TW_POOL_CHUNK];
+} TW_CHUNK;
+
+
+// Every timer in level `l` shares all the digits of `_now` above `l`, and has
+// a greater digit at `l` itself, so the slots behind `_now`'s are empty and
+// each level's first occupied slot is its next to come due. `_bits` marks the
+// occupied slots.
+struct TW_TYPE {
+    size_t _used;
+    TW_TIME_TYPE _now;
+    TW_TIMER* _slots[TW_LEVELS * TW_SLOTS];
+    uint64_t _bits[TW_LEVELS][TW_WORDS];
+    TW_TIMER* _due;
+    TW_TIMER* _due_tail;
+    HR_CONCAT(TW_FAR, _t) _far;
+    TW_TIMER* _free;
+    TW_CHUNK* _chunks;
+    size_t _chunk_used;
+};
+
+
+TW_FUNC bool NAME_(_init)(TW_TYPE* tw, TW_TIME_TYPE now) {
+    if (!HR_CONCAT(TW_FAR, _init)(&tw->_far, 16)) {
+        return false;
+    }
+
+    tw->_used = 0;
+    tw->_now = now;
+    tw->_due = tw->_due_tail = NULL;
+    tw->_free = NULL;
+    tw->_chunks = NULL;
+    tw->_chunk_used = TW_POOL_CHUNK;
+
+    memset(tw->_slots, 0, sizeof(tw->_slots));
+    memset(tw->_bits, 0, sizeof(tw->_bits));
+
+    return true;
+}
+
+
+TW_FUNC void NAME_(_cleanup)(TW_TYPE* tw) {
+    HR_CONCAT(TW_FAR, _cleanup)(&tw->_far);
+
+#if TW_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    // Only the newest chunk, at the front, is partly used.
+    size_t used = tw->_chunk_used;
+#endif
+
+    while (tw->_chunks != NULL) {
+        TW_CHUNK* next = tw->_chunks->next;
+#if TW_STORAGE == HR_STORAGE_OWNED_INDIRECT
+        for (size_t i = 0; i < used; i++) {
+            if (tw->_chunks->timers[i].where != TW_IN_FREE) {
+                TW_FREE_ELEM((tw->_chunks->timers[i].data));
+            }
+        }
+#endif
+#if TW_STORAGE == HR_STORAGE_OWNED_INDIRECT
+        used = TW_POOL_CHUNK;
+#endif
+        free(tw->_chunks);
+        tw->_chunks = next;
+    }
+}
+
+
+TW_FUNC TW_TIMER* NAME_(_alloc_timer)(TW_TYPE* tw) {
+    TW_TIMER* timer = tw->_free;
+
+    if (timer != NULL) {
+        tw->_free = timer->next;
+        return timer;
+    }
+
+    if (tw->_chunk_used == TW_POOL_CHUNK) {
+        TW_CHUNK* chunk = (TW_CHUNK*)malloc(sizeof(TW_CHUNK));
+
+        if (chunk == NULL) {
+            return NULL;
+        }
+
+        chunk->next = tw->_chunks;
+        tw->_chunks = chunk;
+        tw->_chunk_used = 0;
+    }
+
+    return &tw->_chunks->timers[tw->_chunk_used++];
+}
+
+
+TW_FUNC void NAME_(_free_timer)(TW_TYPE* tw, TW_TIMER* timer) {
+    timer->where = TW_IN_FREE;
+    timer->next = tw->_free;
+    tw->_free = timer;
+}
+
+
+// The wheel level whose slots tell `deadline` apart from the current time,
+// or TW_LEVELS and above if it's beyond the wheel's range.
+TW_FUNC size_t NAME_(_level_of)(TW_TYPE* tw, TW_TIME_TYPE deadline) {
+    unsigned long long diff = (unsigned long long)(deadline ^ tw->_now);
+
+    if (diff == 0) {
+        return 0;
+    }
+
+#if defined(__GNUC__)
+    size_t bit = sizeof(unsigned long long) * CHAR_BIT - 1 - __builtin_clzll(diff);
+#else
+    size_t bit = 0;
+    while (diff >>= 1) {
+        bit++;
+    }
+#endif
+    return bit / TW_LEVEL_BITS;
+}
+
+
+TW_FUNC void NAME_(_push_due)(TW_TYPE* tw, TW_TIMER* timer) {
+    timer->where = TW_IN_DUE;
+    timer->next = NULL;
+    timer->prev = tw->_due_tail;
+
+    if (tw->_due_tail != NULL) {
+        tw->_due_tail->next = timer;
+    } else {
+        tw->_due = timer;
+    }
+
+    tw->_due_tail = timer;
+}
+
+
+// File `timer` under its deadline: in the due list if that's already passed,
+// in a slot if it's within the wheel's range, and in the far heap otherwise.
+// Only the last can fail.
+TW_FUNC bool NAME_(_place)(TW_TYPE* tw, TW_TIMER* timer) {
+    if (timer->deadline <= tw->_now) {
+        NAME_(_push_due)(tw, timer);
+        return true;
+    }
+
+    size_t level = NAME_(_level_of)(tw, timer->deadline);
+
+    if (level >= TW_LEVELS) {
+        if (!HR_CONCAT(TW_FAR, _insert)(&tw->_far, timer, &timer->handle)) {
+            return false;
+        }
+
+        timer->where = TW_IN_FAR;
+        return true;
+    }
+
+    size_t slot = (size_t)(timer->deadline >> (TW_LEVEL_BITS * level)) & (TW_SLOTS - 1);
+    size_t where = level * TW_SLOTS + slot;
+
+    timer->where = where;
+    timer->prev = NULL;
+    timer->next = tw->_slots[where];
+
+    if (timer->next != NULL) {
+        timer->next->prev = timer;
+    }
+
+    tw->_slots[where] = timer;
+    tw->_bits[level][slot / 64] |= (uint64_t)1 << (slot % 64);
+
+    return true;
+}
+
+
+// Take `timer` out of whichever list or heap it's in.
+TW_FUNC void NAME_(_unlink)(TW_TYPE* tw, TW_TIMER* timer) {
+    if (timer->where == TW_IN_FAR) {
+        HR_CONCAT(TW_FAR, _remove)(&tw->_far, timer->handle);
+        return;
+    }
+
+    TW_TIMER** head = timer->where == TW_IN_DUE ? &tw->_due : &tw->_slots[timer->where];
+
+    if (timer->prev != NULL) {
+        timer->prev->next = timer->next;
+    } else {
+        *head = timer->next;
+    }
+
+    if (timer->next != NULL) {
+        timer->next->prev = timer->prev;
+    } else if (timer->where == TW_IN_DUE) {
+        tw->_due_tail = timer->prev;
+    }
+
+    if (timer->where != TW_IN_DUE && *head == NULL) {
+        size_t level = timer->where / TW_SLOTS, slot = timer->where % TW_SLOTS;
+        tw->_bits[level][slot / 64] &= ~((uint64_t)1 << (slot % 64));
+    }
+}
+
+
+// The first occupied slot of `level`, or TW_SLOTS if there is none.
+TW_FUNC size_t NAME_(_first_slot)(TW_TYPE* tw, size_t level) {
+    for (size_t i = 0; i < TW_WORDS; i++) {
+        uint64_t word = tw->_bits[level][i];
+
+        if (word != 0) {
+#if defined(__GNUC__)
+            return i * 64 + (size_t)__builtin_ctzll(word);
+#else
+            size_t bit = 0;
+            while (!(word & 1)) {
+                word >>= 1;
+                bit++;
+            }
+            return i * 64 + bit;
+#endif
+        }
+    }
+
+    return TW_SLOTS;
+}
+
+
+// Move time forward to `now`, moving timers into the due list as their
+// deadlines pass. Rather than stepping through every tick, this jumps from
+// one occupied slot to the next. Reaching a slot on level 0 makes all of its
+// timers due; reaching one on a higher level spreads its timers over the
+// levels below, since they now share more of their digits with the time.
+// Far timers move into the wheel once their deadlines come within its range.
+TW_FUNC void NAME_(_collect)(TW_TYPE* tw, TW_TIME_TYPE now) {
+    for (;;) {
+        while (HR_CONCAT(TW_FAR, _size)(&tw->_far) > 0) {
+            TW_TIMER* timer = HR_CONCAT(TW_FAR, _peek)(&tw->_far);
+
+            if (NAME_(_level_of)(tw, timer->deadline) >= TW_LEVELS) {
+                break;
+            }
+
+            HR_CONCAT(TW_FAR, _extract)(&tw->_far);
+            NAME_(_place)(tw, timer);
+        }
+
+        if (tw->_now >= now) {
+            break;
+        }
+
+        size_t level, slot = TW_SLOTS;
+        TW_TIME_TYPE next;
+
+        for (level = 0; level < TW_LEVELS; level++) {
+            slot = NAME_(_first_slot)(tw, level);
+
+            if (slot < TW_SLOTS) {
+                break;
+            }
+        }
+
+        if (slot < TW_SLOTS) {
+            next = (tw->_now & ~TW_LOW_MASK(level + 1))
+                | ((TW_TIME_TYPE)slot << (TW_LEVEL_BITS * level));
+        } else if (HR_CONCAT(TW_FAR, _size)(&tw->_far) > 0) {
+            next = HR_CONCAT(TW_FAR, _peek)(&tw->_far)->deadline & ~TW_RANGE_MASK;
+        } else {
+            break;
+        }
+
+        if (next > now) {
+            break;
+        }
+
+        tw->_now = next;
+
+        if (slot < TW_SLOTS) {
+            size_t where = level * TW_SLOTS + slot;
+            TW_TIMER* timer = tw->_slots[where];
+
+            tw->_slots[where] = NULL;
+            tw->_bits[level][slot / 64] &= ~((uint64_t)1 << (slot % 64));
+
+            while (timer != NULL) {
+                TW_TIMER* next_timer = timer->next;
+                NAME_(_place)(tw, timer);
+                timer = next_timer;
+            }
+        }
+    }
+
+    if (tw->_now < now) {
+        tw->_now = now;
+    }
+}
+
+
+#if TW_STORAGE == HR_STORAGE_DIRECT
+TW_FUNC TW_TIMER* NAME_(_arm)(TW_TYPE* tw, TW_TIME_TYPE deadline, TW_ELEM_TYPE elem)
+#else
+TW_FUNC TW_TIMER* NAME_(_arm)(TW_TYPE* tw, TW_TIME_TYPE deadline, TW_ELEM_TYPE* elem)
+#endif
+{
+    TW_TIMER* timer = NAME_(_alloc_timer)(tw);
+
+    if (timer == NULL) {
+        return NULL;
+    }
+
+#if TW_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    timer->data = (TW_ELEM_TYPE*)(TW_MALLOC_ELEM);
+
+    if (timer->data == NULL) {
+        NAME_(_free_timer)(tw, timer);
+        return NULL;
+    }
+
+    TW_MEMCPY_ELEM(timer->data, elem);
+#else
+    timer->data = elem;
+#endif
+
+    timer->deadline = deadline;
+
+    if (!NAME_(_place)(tw, timer)) {
+#if TW_STORAGE == HR_STORAGE_OWNED_INDIRECT
+        TW_FREE_ELEM((timer->data));
+#endif
+        NAME_(_free_timer)(tw, timer);
+        return NULL;
+    }
+
+    tw->_used += 1;
+
+    return timer;
+}
+
+
+// Move `timer` to a new deadline. This can only fail when a timer within the
+// wheel's range is moved beyond it, in which case it keeps its old deadline.
+TW_FUNC bool NAME_(_rearm)(TW_TYPE* tw, TW_TIMER* timer, TW_TIME_TYPE deadline) {
+    TW_TIME_TYPE old = timer->deadline;
+    bool far = deadline > tw->_now && NAME_(_level_of)(tw, deadline) >= TW_LEVELS;
+
+    timer->deadline = deadline;
+
+    if (timer->where == TW_IN_FAR && far) {
+        if (deadline < old) {
+            HR_CONCAT(TW_FAR, _decrease_key)(&tw->_far, timer->handle);
+        } else {
+            HR_CONCAT(TW_FAR, _increase_key)(&tw->_far, timer->handle);
+        }
+        return true;
+    }
+
+    if (far) {
+        // Get into the heap first, so that failing leaves the timer as it was.
+        if (!HR_CONCAT(TW_FAR, _insert)(&tw->_far, timer, &timer->handle)) {
+            timer->deadline = old;
+            return false;
+        }
+
+        NAME_(_unlink)(tw, timer);
+        timer->where = TW_IN_FAR;
+        return true;
+    }
+
+    NAME_(_unlink)(tw, timer);
+    NAME_(_place)(tw, timer);
+
+    return true;
+}
+
+
+TW_FUNC void NAME_(_cancel)(TW_TYPE* tw, TW_TIMER* timer) {
+    NAME_(_unlink)(tw, timer);
+#if TW_STORAGE == HR_STORAGE_OWNED_INDIRECT
+    TW_FREE_ELEM((timer->data));
+#endif
+    NAME_(_free_timer)(tw, timer);
+    tw->_used -= 1;
+}
+
+
+// Move time forward to `now` and hand out up to `n` of the timers which are
+// then due, in the order they came due. Returns how many were written to
+// `out`; if that's `n`, there may be more, and calling again with the same
+// `now` carries on where this left off. Timers are released as they're handed out.
+#if TW_STORAGE == HR_STORAGE_BORROWED_INDIRECT
+TW_FUNC size_t NAME_(_advance)(TW_TYPE* tw, TW_TIME_TYPE now, TW_ELEM_TYPE** out, size_t n)
+#else
+TW_FUNC size_t NAME_(_advance)(TW_TYPE* tw, TW_TIME_TYPE now, TW_ELEM_TYPE* out, size_t n)
+#endif
+{
+    NAME_(_collect)(tw, now);
+
+    size_t i;
+    for (i = 0; i < n && tw->_due != NULL; i++) {
+        TW_TIMER* timer = tw->_due;
+
+        tw->_due = timer->next;
+
+        if (tw->_due != NULL) {
+            tw->_due->prev = NULL;
+        } else {
+            tw->_due_tail = NULL;
+        }
+
+#if TW_STORAGE == HR_STORAGE_OWNED_INDIRECT
+        TW_MEMCPY_ELEM((&out[i]), (timer->data));
+        TW_FREE_ELEM((timer->data));
+#else
+        out[i] = timer->data;
+#endif
+
+        NAME_(_free_timer)(tw, timer);
+        tw->_used -= 1;
+    }
+
+    return i;
+}
+
+
+TW_FUNC TW_ELEM_TYPE* NAME_(_get)(TW_TIMER* timer) {
+#if TW_STORAGE == HR_STORAGE_DIRECT
+    return &timer->data;
+#else
+    return timer->data;
+#endif
+}
+
+
+TW_FUNC TW_TIME_TYPE NAME_(_deadline)(TW_TIMER* timer) {
+    return timer->deadline;
+}
+
+
+TW_FUNC TW_TIME_TYPE NAME_(_now)(TW_TYPE* tw) {
+    return tw->_now;
+}
+
+
+TW_FUNC size_t NAME_(_size)(TW_TYPE* tw) {
+    return tw->_used;
+}
+
+#endif
+
+
+#undef TW_ELEM_TYPE
+#undef TW_NAME
+#undef TW_TIME_TYPE
+#undef TW_LEVEL_BITS
+#undef TW_LEVELS
+#undef TW_STORAGE
+#undef TW_MALLOC_ELEM
+#undef TW_FREE_ELEM
+#undef TW_MEMCPY_ELEM
+#undef TW_TYPE
+#undef TW_SCOPE
+#undef TW_FUNC
+#undef TW_POOL_CHUNK
+#undef TW_TIMER
+#undef TW_CHUNK
+#undef TW_FAR
+#undef TW_SLOTS
+#undef TW_WORDS
+#undef TW_TIME_BITS
+#undef TW_LOW_MASK
+#undef TW_RANGE_MASK
+#undef TW_IN_DUE
+#undef TW_IN_FAR
+#undef TW_IN_FREE
+#undef NAME_
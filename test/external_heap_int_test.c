@@ -0,0 +1,138 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <limits.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+// Small blocks and a small budget, so that a few thousand elements make for
+// plenty of runs and merges.
+#define EH_SCOPE HR_SCOPE_STATIC_INLINE
+#define EH_ELEM_TYPE int
+#define EH_NAME eh_int
+#define EH_CMP(x, y) ((x) < (y) ? true : false)
+#define EH_BLOCK_BYTES 256
+#include "horror/external_heap.c"
+
+
+#define RANGE 1000
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    eh_int_t* heap = malloc(sizeof(eh_int_t));
+    munit_assert(eh_int_init(heap, 4096));
+    return heap;
+}
+
+
+static void tear_down(void* heap) {
+    eh_int_cleanup(heap);
+    free(heap);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* heap) {
+    size_t counts[RANGE];
+    memset(counts, 0, sizeof(counts));
+
+    size_t i, n = 0, max_runs = 0;
+    int x;
+
+    for (i = 0; i < 3000; i++) {
+        x = munit_rand_int_range(0, RANGE - 1);
+        munit_assert(eh_int_insert(heap, x));
+        counts[x]++;
+        n++;
+
+        if (eh_int_runs(heap) > max_runs) {
+            max_runs = eh_int_runs(heap);
+        }
+
+        // Now and then, take the front, which may be in memory or on disk.
+        if (i % 4 == 3) {
+            int front = *eh_int_peek(heap);
+            munit_assert(eh_int_extract(heap, &x));
+            munit_assert_int(x, ==, front);
+            munit_assert_size(counts[x]--, >, 0);
+            n--;
+        }
+    }
+
+    munit_assert_size(max_runs, >, 1);
+    munit_assert_size(eh_int_size(heap), ==, n);
+
+    int min = -1;
+    while (eh_int_extract(heap, &x)) {
+        munit_assert_int(min, <=, x);
+        munit_assert_size(counts[x]--, >, 0);
+        min = x;
+        n--;
+    }
+
+    munit_assert_size(n, ==, 0);
+    munit_assert_size(eh_int_size(heap), ==, 0);
+    munit_assert_null(eh_int_peek(heap));
+    munit_assert(!eh_int_failed(heap));
+
+    // Many times more elements than fit in memory. Runs are only merged
+    // with others of about their size, so each element is rewritten a few
+    // times, rather than once for every few spills.
+    size_t written = eh_int_written(heap);
+    for (i = 0; i < 40 * 512; i++) {
+        x = munit_rand_int_range(0, RANGE - 1);
+        munit_assert(eh_int_insert(heap, x));
+        counts[x]++;
+    }
+    munit_assert_size(eh_int_written(heap) - written, <=, 3 * 40 * 512);
+
+    min = -1;
+    while (eh_int_extract(heap, &x)) {
+        munit_assert_int(min, <=, x);
+        munit_assert_size(counts[x]--, >, 0);
+        min = x;
+        n++;
+    }
+    munit_assert_size(n, ==, 40 * 512);
+    munit_assert(!eh_int_failed(heap));
+
+    return MUNIT_OK;
+}
+
+
+MunitTest eh_int_test = {
+    "/external_heap EH_SCOPE=HR_SCOPE_STATIC_INLINE EH_ELEM_TYPE=int EH_NAME=int",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
@@ -0,0 +1,152 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_int
+#define HP_CMP(x, y) ((x) < (y) ? true : false)
+#define HP_BOUNDED
+#define HP_DEBUG
+#define HP_DEBUG_DUMP(x) do { fprintf(stderr, "%i", x); } while (0)
+#include "horror/heap.c"
+
+// An owned bounded heap whose allocator can be made to fail, and which counts
+// what it's asked for.
+static size_t allocs;
+static bool alloc_fails;
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_OWNED_INDIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_owned
+#define HP_CMP(x, y) (*(x) < *(y) ? true : false)
+#define HP_BOUNDED
+#define HP_MALLOC_ELEM (allocs++, alloc_fails ? NULL : malloc(sizeof(int)))
+#define HP_FREE_ELEM(ptr) (free(ptr))
+#include "horror/heap.c"
+
+
+#define K 100
+#define N 10000
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    hp_int_t* heap = malloc(sizeof(hp_int_t));
+    hp_int_init(heap, K);
+    return heap;
+}
+
+
+static void tear_down(void* heap) {
+    hp_int_cleanup(heap);
+    free(heap);
+}
+
+
+static int cmp_desc(const void* x, const void* y) {
+    return *(const int*)y - *(const int*)x;
+}
+
+
+static MunitResult test(const MunitParameter params[], void* heap) {
+    static int stream[N];
+
+    // A min-heap bounded to K elements keeps the K largest it has seen.
+    size_t i;
+    for (i = 0; i < N; i++) {
+        stream[i] = munit_rand_int_range(0, 1000000);
+        hp_int_insert(heap, stream[i]);
+        munit_assert_size(hp_int_size(heap), <=, K);
+    }
+
+    munit_assert_size(hp_int_size(heap), ==, K);
+
+    // Anything that doesn't beat the root is turned away.
+    munit_assert_false(hp_int_insert(heap, *hp_int_peek(heap)));
+    munit_assert_false(hp_int_insert(heap, -1));
+
+    int top[K];
+    munit_assert_size(hp_int_drain_sorted(heap, top), ==, K);
+    munit_assert_size(hp_int_size(heap), ==, 0);
+
+    qsort(stream, N, sizeof(int), cmp_desc);
+
+    for (i = 0; i < K; i++) {
+        munit_assert_int(top[i], ==, stream[i]);
+    }
+
+    // Bulk insertion respects the bound too.
+    munit_assert(hp_int_insert_many(heap, stream + K, N - K));
+    munit_assert_size(hp_int_size(heap), ==, K);
+    munit_assert_int(*hp_int_peek(heap), ==, stream[2 * K - 1]);
+
+    // Until the heap is full, false means an element couldn't be allocated.
+    // Once it's full, an element which gets in reuses the root's memory, so
+    // false only ever means it was turned away.
+    hp_owned_t owned;
+    munit_assert(hp_owned_init(&owned, 2));
+    int x = 5;
+    alloc_fails = true;
+    munit_assert_false(hp_owned_insert(&owned, &x));
+    munit_assert_size(hp_owned_size(&owned), ==, 0);
+    alloc_fails = false;
+    munit_assert(hp_owned_insert(&owned, &x));
+    x = 7;
+    munit_assert(hp_owned_insert(&owned, &x));
+
+    alloc_fails = true;
+    allocs = 0;
+    x = 1;
+    munit_assert_false(hp_owned_insert(&owned, &x));
+    x = 9;
+    munit_assert(hp_owned_insert(&owned, &x));
+    munit_assert_size(allocs, ==, 0);
+    munit_assert_int(*hp_owned_peek(&owned), ==, 7);
+    alloc_fails = false;
+    hp_owned_cleanup(&owned);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest hp_int_bounded_test = {
+    "/heap HP_SCOPE=HR_SCOPE_STATIC_INLINE HP_ELEM_TYPE=int HP_NAME=int HP_BOUNDED",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
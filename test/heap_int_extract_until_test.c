@@ -0,0 +1,132 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_int
+#define HP_CMP(x, y) ((x) < (y) ? true : false)
+#include "horror/heap.c"
+
+#define N 300
+
+
+static int ascending(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    hp_int_t* heap = malloc(sizeof(hp_int_t));
+    hp_int_init(heap, 8);
+    return heap;
+}
+
+
+static void tear_down(void* heap) {
+    hp_int_cleanup(heap);
+    free(heap);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* heap) {
+    int elems[N], out[N];
+    size_t n = munit_rand_int_range(0, N);
+
+    for (size_t i = 0; i < n; i++) {
+        elems[i] = munit_rand_int_range(0, 1000);
+    }
+
+    munit_assert(hp_int_build(heap, elems, n));
+    qsort(elems, n, sizeof(int), ascending);
+
+    int threshold = munit_rand_int_range(0, 1000);
+    size_t max = munit_rand_int_range(0, N);
+    size_t below = 0;
+    while (below < n && elems[below] < threshold) {
+        below++;
+    }
+    size_t expected = below < max ? below : max;
+
+    // Everything below the threshold comes out, in no particular order unless
+    // there are more than `max`, in which case the first `max` come out in
+    // order.
+    munit_assert_size(hp_int_extract_until(heap, threshold, out, max), ==, expected);
+    if (below > max) {
+        munit_assert_memory_equal(expected * sizeof(int), out, elems);
+    } else {
+        qsort(out, expected, sizeof(int), ascending);
+        munit_assert_memory_equal(expected * sizeof(int), out, elems);
+    }
+
+    // What's left is still a heap of the rest.
+    munit_assert_size(hp_int_size(heap), ==, n - expected);
+    size_t left = hp_int_extract_many(heap, out, SIZE_MAX);
+    munit_assert_size(left, ==, n - expected);
+    munit_assert_memory_equal(left * sizeof(int), out, elems + expected);
+    munit_assert_size(hp_int_size(heap), ==, 0);
+
+    // Churn with batches in between, as a scheduler's tick loop would.
+    int now = 0, last = INT_MIN;
+    for (size_t i = 0; i < 200; i++) {
+        munit_assert(hp_int_insert(heap, now + munit_rand_int_range(0, 50)));
+
+        if (i % 10 == 9) {
+            now += 10;
+            size_t k = hp_int_extract_until(heap, now, out, N);
+            for (size_t j = 0; j < k; j++) {
+                munit_assert_int(out[j], <, now);
+                munit_assert_int(out[j], >=, last);
+            }
+            last = now;
+            if (hp_int_size(heap) > 0) {
+                munit_assert_int(*hp_int_peek(heap), >=, now);
+            }
+        }
+    }
+
+    return MUNIT_OK;
+}
+
+
+MunitTest hp_int_extract_until_test = {
+    "/heap HP_SCOPE=HR_SCOPE_STATIC_INLINE HP_ELEM_TYPE=int HP_NAME=int extract_until",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
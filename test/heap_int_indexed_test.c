@@ -0,0 +1,160 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_int
+#define HP_CMP(x, y) ((x) < (y) ? true : false)
+#define HP_INDEXED
+#define HP_DEBUG
+#define HP_DEBUG_DUMP(x) do { fprintf(stderr, "%i", x); } while (0)
+#include "horror/heap.c"
+
+
+#define N 500
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    hp_int_t* heap = malloc(sizeof(hp_int_t));
+    hp_int_init(heap, 8);
+    return heap;
+}
+
+
+static void tear_down(void* heap) {
+    hp_int_cleanup(heap);
+    free(heap);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* heap) {
+    int value[N];
+    bool live[N] = { false };
+    size_t handles[N];
+
+    size_t i;
+    for (i = 0; i < N; i++) {
+        int x = munit_rand_int_range(0, 10000);
+        munit_assert(hp_int_insert(heap, x, &handles[i]));
+        munit_assert_size(handles[i], <, N);
+        munit_assert_false(live[handles[i]]);
+        live[handles[i]] = true;
+        value[handles[i]] = x;
+    }
+
+    // Shuffle every element's key around, and remove a few of them.
+    for (i = 0; i < N; i++) {
+        size_t h = handles[i];
+        int* elem = hp_int_get(heap, h);
+        munit_assert_int(*elem, ==, value[h]);
+
+        switch (i % 3) {
+        case 0:
+            *elem = value[h] = value[h] - munit_rand_int_range(0, 10000);
+            hp_int_decrease_key(heap, h);
+            break;
+        case 1:
+            *elem = value[h] = value[h] + munit_rand_int_range(0, 10000);
+            hp_int_increase_key(heap, h);
+            break;
+        case 2:
+            hp_int_remove(heap, h);
+            live[h] = false;
+            break;
+        }
+    }
+
+    // Released handles are handed out again.
+    size_t handle;
+    munit_assert(hp_int_insert(heap, 0, &handle));
+    munit_assert_false(live[handle]);
+    live[handle] = true;
+    value[handle] = 0;
+
+    size_t remaining = 0;
+    for (i = 0; i < N; i++) {
+        if (live[i]) {
+            remaining++;
+        }
+    }
+
+    munit_assert_size(hp_int_size(heap), ==, remaining);
+
+    // A batch takes everything below the threshold and releases its handles,
+    // and every other handle still finds its element.
+    int out[N];
+    size_t k = hp_int_extract_until(heap, 0, out, N);
+    for (i = 0; i < k; i++) {
+        munit_assert_int(out[i], <, 0);
+    }
+    for (i = 0; i < N; i++) {
+        if (live[i] && value[i] < 0) {
+            live[i] = false;
+            remaining--;
+        } else if (live[i]) {
+            munit_assert_int(*hp_int_get(heap, i), ==, value[i]);
+        }
+    }
+    munit_assert_size(hp_int_size(heap), ==, remaining);
+
+    int min = INT_MIN;
+    while (hp_int_size(heap) > 0) {
+        int x = hp_int_extract(heap);
+        munit_assert_int(min, <=, x);
+        min = x;
+
+        // Every extracted value belongs to exactly one live handle.
+        for (i = 0; i < N; i++) {
+            if (live[i] && value[i] == x) {
+                live[i] = false;
+                break;
+            }
+        }
+
+        munit_assert_size(i, <, N);
+    }
+
+    return MUNIT_OK;
+}
+
+
+MunitTest hp_int_indexed_test = {
+    "/heap HP_SCOPE=HR_SCOPE_STATIC_INLINE HP_ELEM_TYPE=int HP_NAME=int HP_INDEXED",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
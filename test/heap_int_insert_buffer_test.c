@@ -0,0 +1,182 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_int
+#define HP_CMP(x, y) ((x) < (y) ? true : false)
+#define HP_INSERT_BUFFER 8
+#include "horror/heap.c"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_idx
+#define HP_CMP(x, y) ((x) < (y) ? true : false)
+#define HP_INDEXED
+#define HP_INSERT_BUFFER 8
+#include "horror/heap.c"
+
+
+#define N 500
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    hp_int_t* heap = malloc(sizeof(hp_int_t));
+    hp_int_init(heap, 8);
+    return heap;
+}
+
+
+static void tear_down(void* heap) {
+    hp_int_cleanup(heap);
+    free(heap);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* heap) {
+    // Buffered insertions count toward the size, and peeking merges them in,
+    // whether the buffer is big or small next to the heap.
+    int min = INT_MAX;
+    size_t i;
+    for (i = 0; i < 500; i++) {
+        int x = munit_rand_int_range(0, 10000);
+        if (x < min) {
+            min = x;
+        }
+
+        munit_assert(hp_int_insert(heap, x));
+        munit_assert_size(hp_int_size(heap), ==, i + 1);
+
+        if (munit_rand_int_range(0, 19) == 0) {
+            munit_assert_int(*hp_int_peek(heap), ==, min);
+        }
+    }
+
+    // Insertions between extractions are never missed.
+    int last = INT_MIN;
+    for (i = 0; i < 1000; i++) {
+        if (i % 4 == 3) {
+            int x = hp_int_extract(heap);
+            munit_assert_int(last, <=, x);
+            last = x;
+        } else {
+            munit_assert(hp_int_insert(heap, last + munit_rand_int_range(0, 10000)));
+        }
+    }
+
+    // Everything else that looks at the root merges the buffer first too.
+    munit_assert(hp_int_insert(heap, last));
+    munit_assert_int(hp_int_pushpop(heap, last + 1), ==, last);
+    munit_assert(hp_int_insert(heap, last));
+    munit_assert_int(hp_int_replace(heap, INT_MAX), ==, last);
+
+    int elems[20], out[21];
+    for (i = 0; i < 20; i++) {
+        elems[i] = last - 1;
+    }
+    munit_assert(hp_int_insert(heap, last - 2));
+    munit_assert(hp_int_insert_many(heap, elems, 20));
+    munit_assert_size(hp_int_extract_many(heap, out, 1), ==, 1);
+    munit_assert_int(out[0], ==, last - 2);
+    munit_assert(hp_int_insert(heap, last - 3));
+    munit_assert_size(hp_int_extract_until(heap, last, out, 21), ==, 21);
+
+    size_t n = hp_int_size(heap);
+    munit_assert_size(n, ==, 500 + 750 - 250 + 2);
+    while (hp_int_size(heap) > 0) {
+        int x = hp_int_extract(heap);
+        munit_assert_int(last, <=, x);
+        last = x;
+    }
+    munit_assert_int(last, ==, INT_MAX);
+
+    // Keys changed through handles, both in the heap proper and still in the
+    // buffer, end up in order once the buffer is merged.
+    hp_idx_t idx;
+    size_t h[N];
+    munit_assert(hp_idx_init(&idx, 8));
+    munit_assert(hp_idx_insert(&idx, 1, &h[0]));
+    munit_assert(hp_idx_insert(&idx, 5, &h[1]));
+    munit_assert(hp_idx_insert(&idx, 9, &h[2]));
+    munit_assert(hp_idx_insert(&idx, 6, &h[3]));
+    munit_assert_int(*hp_idx_peek(&idx), ==, 1);
+    munit_assert(hp_idx_insert(&idx, 8, &h[4]));
+    *hp_idx_get(&idx, h[1]) = 100;
+    hp_idx_increase_key(&idx, h[1]);
+    *hp_idx_get(&idx, h[4]) = 0;
+    hp_idx_decrease_key(&idx, h[4]);
+    int expect[] = { 0, 1, 6, 9, 100 };
+    for (i = 0; i < 5; i++) {
+        munit_assert_int(hp_idx_extract(&idx), ==, expect[i]);
+    }
+
+    int value[N];
+    for (i = 0; i < N; i++) {
+        value[i] = munit_rand_int_range(0, 10000);
+        munit_assert(hp_idx_insert(&idx, value[i], &h[i]));
+        if (i % 3 == 2) {
+            size_t j = (size_t)munit_rand_int_range(0, (int)i);
+            *hp_idx_get(&idx, h[j]) = value[j] += munit_rand_int_range(-10000, 10000);
+            if (munit_rand_int_range(0, 1)) {
+                hp_idx_decrease_key(&idx, h[j]);
+                hp_idx_increase_key(&idx, h[j]);
+            } else {
+                hp_idx_increase_key(&idx, h[j]);
+                hp_idx_decrease_key(&idx, h[j]);
+            }
+        }
+    }
+    last = INT_MIN;
+    for (i = 0; i < N; i++) {
+        int x = hp_idx_extract(&idx);
+        munit_assert_int(last, <=, x);
+        last = x;
+    }
+    hp_idx_cleanup(&idx);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest hp_int_insert_buffer_test = {
+    "/heap HP_SCOPE=HR_SCOPE_STATIC_INLINE HP_ELEM_TYPE=int HP_NAME=int HP_INSERT_BUFFER=8",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
@@ -0,0 +1,119 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_int
+#define HP_CMP(x, y) ((x) < (y) ? true : false)
+#define HP_DEBUG
+#define HP_DEBUG_DUMP(x) do { fprintf(stderr, "%i", x); } while (0)
+#include "horror/heap.c"
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    hp_int_t* heap = malloc(sizeof(hp_int_t));
+    hp_int_init(heap, 8);
+    return heap;
+}
+
+
+static void tear_down(void* heap) {
+    hp_int_cleanup(heap);
+    free(heap);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* heap) {
+    // On an empty heap, or with an element that would come out first anyway,
+    // pushpop hands the element straight back.
+    munit_assert_int(hp_int_pushpop(heap, 7), ==, 7);
+    munit_assert_size(hp_int_size(heap), ==, 0);
+
+    size_t i;
+    for (i = 0; i < 100; i++) {
+        munit_assert(hp_int_insert(heap, munit_rand_int_range(100, 1000)));
+    }
+
+    munit_assert_int(hp_int_pushpop(heap, 50), ==, 50);
+    munit_assert_size(hp_int_size(heap), ==, 100);
+
+    // Otherwise, it gives back the old root and keeps the element.
+    int root = *hp_int_peek(heap);
+    munit_assert_int(hp_int_pushpop(heap, 5000), ==, root);
+    munit_assert_size(hp_int_size(heap), ==, 100);
+
+    // Replace always swaps the root out, even for an element that precedes
+    // everything else.
+    root = *hp_int_peek(heap);
+    munit_assert_int(hp_int_replace(heap, 1), ==, root);
+    munit_assert_int(*hp_int_peek(heap), ==, 1);
+
+    // Each step replaces the smallest element with one larger than anything
+    // the heap started with, so those all come out in order.
+    int last = INT_MIN;
+    for (i = 0; i < 1000; i++) {
+        int x = hp_int_replace(heap, 2000 + munit_rand_int_range(0, 1000));
+        if (x >= 2000) {
+            break;
+        }
+        munit_assert_int(last, <=, x);
+        last = x;
+    }
+
+    munit_assert_size(i, ==, 99);
+    last = INT_MIN;
+
+    int max = 0;
+    while (hp_int_size(heap) > 0) {
+        int x = hp_int_extract(heap);
+        munit_assert_int(last, <=, x);
+        last = x;
+        max = x;
+    }
+
+    munit_assert_int(max, ==, 5000);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest hp_int_replace_test = {
+    "/heap HP_SCOPE=HR_SCOPE_STATIC_INLINE HP_ELEM_TYPE=int HP_NAME=int replace",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
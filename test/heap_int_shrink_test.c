@@ -0,0 +1,134 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_int
+#define HP_CMP(x, y) ((x) < (y) ? true : false)
+#define HP_AUTO_SHRINK
+#include "horror/heap.c"
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    hp_int_t* heap = malloc(sizeof(hp_int_t));
+    hp_int_init(heap, 8);
+    return heap;
+}
+
+
+static void tear_down(void* heap) {
+    hp_int_cleanup(heap);
+    free(heap);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* heap) {
+    size_t i;
+    for (i = 0; i < 1024; i++) {
+        munit_assert(hp_int_insert(heap, munit_rand_int_range(0, 100)));
+    }
+    munit_assert_size(hp_int_capacity(heap), ==, 1024);
+
+    // Extraction halves the heap whenever it's less than a quarter full.
+    int last = 0;
+    for (i = 0; i < 800; i++) {
+        int x = hp_int_extract(heap);
+        munit_assert_int(last, <=, x);
+        last = x;
+
+        size_t used = hp_int_size(heap), size = hp_int_capacity(heap);
+        munit_assert_size(used, >=, size / 4);
+    }
+    munit_assert_size(hp_int_capacity(heap), ==, 512);
+
+    // Once halved, the heap is half full, so a few insertions and
+    // extractions either way don't resize it.
+    for (i = 0; i < 100; i++) {
+        hp_int_extract(heap);
+    }
+    munit_assert_size(hp_int_capacity(heap), ==, 256);
+    for (i = 0; i < 100; i++) {
+        munit_assert(hp_int_insert(heap, munit_rand_int_range(0, 100)));
+        hp_int_extract(heap);
+    }
+    munit_assert_size(hp_int_capacity(heap), ==, 256);
+
+    // It never shrinks by itself below the size it started with.
+    while (hp_int_size(heap) > 0) {
+        hp_int_extract(heap);
+    }
+    munit_assert_size(hp_int_capacity(heap), ==, 8);
+
+    // Reserving sizes the heap exactly, never shrinks it, and keeps it from
+    // shrinking by itself until the reservation is dropped.
+    munit_assert(hp_int_reserve(heap, 1 << 20));
+    munit_assert_size(hp_int_capacity(heap), ==, 1 << 20);
+    munit_assert(hp_int_reserve(heap, 10));
+    munit_assert_size(hp_int_capacity(heap), ==, 1 << 20);
+    for (i = 0; i < 100; i++) {
+        munit_assert(hp_int_insert(heap, munit_rand_int_range(0, 100)));
+    }
+    while (hp_int_size(heap) > 0) {
+        hp_int_extract(heap);
+    }
+    munit_assert_size(hp_int_capacity(heap), ==, 1 << 20);
+
+    munit_assert(hp_int_shrink_to_fit(heap));
+    munit_assert_size(hp_int_capacity(heap), ==, 1);
+    munit_assert(hp_int_insert(heap, 3));
+    munit_assert(hp_int_insert(heap, 1));
+    munit_assert_int(hp_int_extract(heap), ==, 1);
+
+    // Without the reservation, it shrinks all the way back down again.
+    for (i = 0; i < 1024; i++) {
+        munit_assert(hp_int_insert(heap, munit_rand_int_range(0, 100)));
+    }
+    while (hp_int_size(heap) > 0) {
+        hp_int_extract(heap);
+    }
+    munit_assert_size(hp_int_capacity(heap), <=, 2);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest hp_int_shrink_test = {
+    "/heap HP_SCOPE=HR_SCOPE_STATIC_INLINE HP_ELEM_TYPE=int HP_NAME=int HP_AUTO_SHRINK",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
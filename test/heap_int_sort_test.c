@@ -0,0 +1,101 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE int
+#define HP_NAME hp_int
+#define HP_CMP(x, y) ((x) < (y) ? true : false)
+#include "horror/heap.c"
+
+#define N 200
+
+
+static int ascending(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* _) {
+    int array[N], expected[N];
+    size_t n = munit_rand_int_range(0, N);
+
+    for (size_t i = 0; i < n; i++) {
+        array[i] = expected[i] = munit_rand_int_range(0, 100);
+    }
+
+    // Sorting follows HP_CMP, like qsort with the same comparison.
+    qsort(expected, n, sizeof(int), ascending);
+    hp_int_sort(array, n);
+    munit_assert_memory_equal(n * sizeof(int), array, expected);
+
+    for (size_t i = 0; i < n; i++) {
+        array[i] = expected[i] = munit_rand_int_range(0, 100);
+    }
+
+    long sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += array[i];
+    }
+
+    // The front k are the k smallest, which a min-heap would extract first,
+    // in order, and the rest are the other elements in any order.
+    size_t k = munit_rand_int_range(0, N + 10);
+    size_t front = k < n ? k : n;
+    qsort(expected, n, sizeof(int), ascending);
+    hp_int_partial_sort(array, n, k);
+    munit_assert_memory_equal(front * sizeof(int), array, expected);
+
+    for (size_t i = front; i > 0 && i < n; i++) {
+        munit_assert_int(array[i], >=, array[front - 1]);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        sum -= array[i];
+    }
+    munit_assert_long(sum, ==, 0);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest hp_int_sort_test = {
+    "/heap HP_SCOPE=HR_SCOPE_STATIC_INLINE HP_ELEM_TYPE=int HP_NAME=int sort",
+    test,
+    NULL,
+    NULL,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
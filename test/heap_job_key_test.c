@@ -0,0 +1,195 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <limits.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+// A record much bigger than its key, so that only the key should move.
+typedef struct job_s {
+    uint32_t prio;
+    uint32_t check;
+    char payload[48];
+} job_t;
+
+#define HP_SCOPE HR_SCOPE_STATIC_INLINE
+#define HP_STORAGE HR_STORAGE_DIRECT
+#define HP_ELEM_TYPE job_t
+#define HP_NAME hp_job
+#define HP_KEY_TYPE uint32_t
+#define HP_KEY_OF(x) ((x).prio)
+#define HP_CMP(x, y) ((x) < (y) ? true : false)
+#define HP_DEBUG
+#define HP_DEBUG_DUMP(x) do { fprintf(stderr, "%u", (unsigned)(x).prio); } while (0)
+#include "horror/heap.c"
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    hp_job_t* heap = malloc(sizeof(hp_job_t));
+    hp_job_init(heap, 8);
+    return heap;
+}
+
+
+static void tear_down(void* heap) {
+    hp_job_cleanup(heap);
+    free(heap);
+}
+
+
+static job_t make_job(uint32_t prio) {
+    job_t job;
+    job.prio = prio;
+    job.check = prio * 2654435761u;
+    memset(job.payload, (int)(prio & 0x7f), sizeof(job.payload));
+    return job;
+}
+
+
+static void check_job(const job_t* job) {
+    munit_assert_uint32(job->check, ==, job->prio * 2654435761u);
+    size_t i;
+    for (i = 0; i < sizeof(job->payload); i++) {
+        munit_assert_int(job->payload[i], ==, (int)(job->prio & 0x7f));
+    }
+}
+
+
+// Drain the heap, checking that records come out whole, in order, and that
+// there are `n` of them.
+static void drain(hp_job_t* heap, size_t n) {
+    munit_assert_size(hp_job_size(heap), ==, n);
+
+    uint32_t min = 0;
+    while (hp_job_size(heap) > 0) {
+        munit_assert_uint32(min, <=, hp_job_peek(heap)->prio);
+        job_t job = hp_job_extract(heap);
+        check_job(&job);
+        min = job.prio;
+    }
+}
+
+
+static MunitResult test(const MunitParameter params[], void* heap) {
+    job_t jobs[200];
+
+    size_t i;
+    for (i = 0; i < 200; i++) {
+        jobs[i] = make_job((uint32_t)munit_rand_int_range(0, 1000));
+    }
+
+    for (i = 0; i < 200; i++) {
+        munit_assert(hp_job_insert(heap, jobs[i]));
+    }
+    drain(heap, 200);
+
+    // Interleave inserts and extracts so that payload slots are recycled.
+    for (i = 0; i < 200; i++) {
+        munit_assert(hp_job_insert(heap, jobs[i]));
+        if (i % 3 == 2) {
+            job_t job = hp_job_extract(heap);
+            check_job(&job);
+        }
+    }
+    drain(heap, 200 - 200 / 3);
+
+    // Replace and pushpop hand back the old root or the new element whole.
+    munit_assert(hp_job_build(heap, jobs, 100));
+    for (i = 100; i < 200; i++) {
+        uint32_t root = hp_job_peek(heap)->prio;
+        job_t job = i % 2 ? hp_job_replace(heap, jobs[i])
+                          : hp_job_pushpop(heap, jobs[i]);
+        check_job(&job);
+        uint32_t bound = i % 2 ? root : jobs[i].prio;
+        munit_assert_uint32(job.prio, <=, bound);
+    }
+    drain(heap, 100);
+
+    munit_assert(hp_job_build(heap, jobs, 100));
+    munit_assert(hp_job_insert_many(heap, jobs + 100, 100));
+    drain(heap, 200);
+
+    job_t sorted[200];
+    munit_assert(hp_job_build(heap, jobs, 200));
+    munit_assert_size(hp_job_drain_sorted(heap, sorted), ==, 200);
+    for (i = 0; i < 200; i++) {
+        check_job(&sorted[i]);
+        if (i > 0) {
+            munit_assert_uint32(sorted[i - 1].prio, >=, sorted[i].prio);
+        }
+    }
+    munit_assert_size(hp_job_size(heap), ==, 0);
+
+    // Shrinking below the payload slots in use packs the survivors down
+    // into the free slots first.
+    for (i = 0; i < 200; i++) {
+        munit_assert(hp_job_insert(heap, jobs[i]));
+    }
+    for (i = 0; i < 150; i++) {
+        hp_job_extract(heap);
+    }
+    munit_assert(hp_job_shrink_to_fit(heap));
+    munit_assert_size(hp_job_capacity(heap), ==, 50);
+    munit_assert(hp_job_insert_many(heap, jobs, 10));
+    drain(heap, 60);
+
+    // Batches copy whole records out of the payload array, keyed by the
+    // threshold alone, or in order when capped.
+    munit_assert(hp_job_build(heap, jobs, 200));
+    size_t k = hp_job_extract_until(heap, 500, sorted, 200);
+    for (i = 0; i < k; i++) {
+        check_job(&sorted[i]);
+        munit_assert_uint32(sorted[i].prio, <, 500);
+    }
+    size_t m = hp_job_extract_many(heap, sorted, 20);
+    for (i = 0; i < m; i++) {
+        check_job(&sorted[i]);
+        munit_assert_uint32(sorted[i].prio, >=, 500);
+        if (i > 0) {
+            munit_assert_uint32(sorted[i - 1].prio, <=, sorted[i].prio);
+        }
+    }
+    drain(heap, 200 - k - m);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest hp_job_key_test = {
+    "/heap HP_SCOPE=HR_SCOPE_STATIC_INLINE HP_ELEM_TYPE=job_t HP_NAME=job HP_KEY_TYPE=uint32_t",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
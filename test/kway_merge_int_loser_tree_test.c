@@ -0,0 +1,141 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <limits.h>
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+// Small blocks, so that callback sources are pulled from many times.
+#define KM_SCOPE HR_SCOPE_STATIC_INLINE
+#define KM_ELEM_TYPE int
+#define KM_NAME km_int
+#define KM_CMP(x, y) ((x) < (y) ? true : false)
+#define KM_BLOCK 16
+#define KM_LOSER_TREE
+#include "horror/kway_merge.c"
+
+
+#define K 20
+#define MAX_LEN 100
+#define RANGE 200
+
+
+typedef struct {
+    const int* elems;
+    size_t n;
+} source_t;
+
+
+static size_t pull(void* ctx, int* buf, size_t n) {
+    source_t* s = ctx;
+    size_t m = s->n < n ? s->n : n;
+
+    memcpy(buf, s->elems, m * sizeof(int));
+    s->elems += m;
+    s->n -= m;
+
+    return m;
+}
+
+
+static int cmp_int(const void* x, const void* y) {
+    return *(const int*)x - *(const int*)y;
+}
+
+
+static MunitResult test(const MunitParameter params[], void* _) {
+    int runs[K][MAX_LEN];
+    size_t lens[K];
+    source_t sources[K];
+    size_t counts[RANGE];
+    size_t i, j, total = 0;
+
+    memset(counts, 0, sizeof(counts));
+
+    // Every other source is pulled through a callback, and some are empty.
+    km_int_t km;
+    munit_assert(km_int_init(&km));
+
+    for (i = 0; i < K; i++) {
+        lens[i] = (size_t)munit_rand_int_range(0, MAX_LEN);
+        for (j = 0; j < lens[i]; j++) {
+            runs[i][j] = munit_rand_int_range(0, RANGE - 1);
+            counts[runs[i][j]]++;
+        }
+        qsort(runs[i], lens[i], sizeof(int), cmp_int);
+        total += lens[i];
+
+        if (i % 2 == 0) {
+            munit_assert(km_int_add_array(&km, runs[i], lens[i]));
+        } else {
+            sources[i].elems = runs[i];
+            sources[i].n = lens[i];
+            munit_assert(km_int_add_source(&km, pull, &sources[i]));
+        }
+    }
+
+    // Take the output in blocks of awkward sizes.
+    int out[7];
+    int last = -1;
+    size_t n, merged = 0;
+
+    while ((n = km_int_next(&km, out, (size_t)munit_rand_int_range(1, 7))) > 0) {
+        for (j = 0; j < n; j++) {
+            munit_assert_int(last, <=, out[j]);
+            munit_assert_size(counts[out[j]]--, >, 0);
+            last = out[j];
+        }
+        merged += n;
+    }
+
+    munit_assert_size(merged, ==, total);
+    munit_assert_size(km_int_next(&km, out, 7), ==, 0);
+    km_int_cleanup(&km);
+
+    // With no sources at all, the stream is empty from the start.
+    munit_assert(km_int_init(&km));
+    munit_assert_size(km_int_next(&km, out, 7), ==, 0);
+    km_int_cleanup(&km);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest km_int_loser_tree_test = {
+    "/kway_merge KM_SCOPE=HR_SCOPE_STATIC_INLINE KM_ELEM_TYPE=int KM_NAME=int KM_LOSER_TREE",
+    test,
+    NULL,
+    NULL,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
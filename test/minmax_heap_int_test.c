@@ -0,0 +1,135 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+#define MM_SCOPE HR_SCOPE_STATIC_INLINE
+#define MM_STORAGE HR_STORAGE_DIRECT
+#define MM_ELEM_TYPE int
+#define MM_NAME mm_int
+#define MM_CMP(x, y) ((x) < (y) ? true : false)
+#include "horror/minmax_heap.c"
+
+
+#define RANGE 256
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    mm_int_t* heap = malloc(sizeof(mm_int_t));
+    mm_int_init(heap, 1);
+    return heap;
+}
+
+
+static void tear_down(void* heap) {
+    mm_int_cleanup(heap);
+    free(heap);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* heap) {
+    // How many of each value the heap should hold.
+    size_t counts[RANGE] = { 0 };
+    size_t used = 0, i;
+
+    for (i = 0; i < 200; i++) {
+        int x = munit_rand_int_range(0, RANGE - 1);
+        munit_assert_true(mm_int_insert(heap, x));
+        counts[x]++;
+        used++;
+    }
+
+    // Mix inserts with extraction from both ends, checking each end against
+    // the counts as we go.
+    for (i = 0; i < 1000; i++) {
+        int min = 0, max = RANGE - 1;
+
+        munit_assert_size(mm_int_size(heap), ==, used);
+
+        if (used > 0) {
+            while (counts[min] == 0) min++;
+            while (counts[max] == 0) max--;
+
+            munit_assert_int(*mm_int_peek_min(heap), ==, min);
+            munit_assert_int(*mm_int_peek_max(heap), ==, max);
+        }
+
+        switch (used > 0 ? munit_rand_int_range(0, 2) : 0) {
+        case 0: {
+            int x = munit_rand_int_range(0, RANGE - 1);
+            munit_assert_true(mm_int_insert(heap, x));
+            counts[x]++;
+            used++;
+            break;
+        }
+        case 1:
+            munit_assert_int(mm_int_extract_min(heap), ==, min);
+            counts[min]--;
+            used--;
+            break;
+        case 2:
+            munit_assert_int(mm_int_extract_max(heap), ==, max);
+            counts[max]--;
+            used--;
+            break;
+        }
+    }
+
+    // Drain from alternating ends until the two meet.
+    int lo = 0, hi = RANGE - 1;
+    for (i = 0; used > 0; i++, used--) {
+        if (i % 2 == 0) {
+            int x = mm_int_extract_min(heap);
+            munit_assert_int(lo, <=, x);
+            lo = x;
+        } else {
+            int x = mm_int_extract_max(heap);
+            munit_assert_int(hi, >=, x);
+            hi = x;
+        }
+        munit_assert_int(lo, <=, hi);
+    }
+
+    munit_assert_size(mm_int_size(heap), ==, 0);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest mm_int_test = {
+    "/minmax_heap MM_SCOPE=HR_SCOPE_STATIC_INLINE MM_ELEM_TYPE=int MM_NAME=int",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
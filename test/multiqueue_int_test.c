@@ -0,0 +1,149 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <limits.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+#define MQ_SCOPE HR_SCOPE_STATIC_INLINE
+#define MQ_STORAGE HR_STORAGE_DIRECT
+#define MQ_ELEM_TYPE int
+#define MQ_NAME mq_int
+#define MQ_CMP(x, y) ((x) < (y) ? true : false)
+#include "horror/multiqueue.c"
+
+
+#define THREADS 4
+#define PER_THREAD 200
+
+
+typedef struct {
+    mq_int_t* mq;
+    int first;
+    uint64_t rng;
+    int taken[PER_THREAD];
+    size_t n_taken;
+    size_t n_failed;
+} worker_t;
+
+
+// Insert this worker's block of values, taking one out after every second.
+// Failures are only counted here, and asserted on once the thread is joined,
+// since munit can't report them from any thread but the main one.
+static void* work(void* arg) {
+    worker_t* w = arg;
+
+    for (int i = 0; i < PER_THREAD; i++) {
+        if (!mq_int_insert(w->mq, w->first + i, &w->rng)) {
+            w->n_failed++;
+        }
+
+        int x;
+        if (i % 2 == 1 && mq_int_extract(w->mq, &x, &w->rng)) {
+            w->taken[w->n_taken++] = x;
+        }
+    }
+
+    return NULL;
+}
+
+
+static MunitResult test(const MunitParameter params[], void* _) {
+    mq_int_t mq;
+    uint64_t rng = 1;
+    int x;
+
+    // With a single shard, it's an ordinary heap.
+    munit_assert(mq_int_init(&mq, 1, 8));
+    for (int i = 0; i < 300; i++) {
+        munit_assert(mq_int_insert(&mq, munit_rand_int_range(0, 1000), &rng));
+    }
+    munit_assert_size(mq_int_size(&mq), ==, 300);
+
+    int min = -1;
+    while (mq_int_extract(&mq, &x, &rng)) {
+        munit_assert_int(min, <=, x);
+        min = x;
+    }
+    munit_assert_size(mq_int_size(&mq), ==, 0);
+    mq_int_cleanup(&mq);
+
+    // With several, everything still comes out exactly once, and once they're
+    // all empty extraction says so.
+    munit_assert(mq_int_init(&mq, 2 * THREADS, 8));
+
+    worker_t workers[THREADS];
+    pthread_t threads[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+        workers[t].mq = &mq;
+        workers[t].first = t * PER_THREAD;
+        workers[t].rng = (uint64_t)t;
+        workers[t].n_taken = 0;
+        workers[t].n_failed = 0;
+        munit_assert_int(pthread_create(&threads[t], NULL, work, &workers[t]), ==, 0);
+    }
+
+    char seen[THREADS * PER_THREAD];
+    memset(seen, 0, sizeof(seen));
+
+    for (int t = 0; t < THREADS; t++) {
+        munit_assert_int(pthread_join(threads[t], NULL), ==, 0);
+        munit_assert_size(workers[t].n_failed, ==, 0);
+        for (size_t i = 0; i < workers[t].n_taken; i++) {
+            munit_assert_int(seen[workers[t].taken[i]]++, ==, 0);
+        }
+    }
+
+    while (mq_int_extract(&mq, &x, &rng)) {
+        munit_assert_int(seen[x]++, ==, 0);
+    }
+
+    for (int i = 0; i < THREADS * PER_THREAD; i++) {
+        munit_assert_int(seen[i], ==, 1);
+    }
+
+    mq_int_cleanup(&mq);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest mq_int_test = {
+    "/multiqueue MQ_SCOPE=HR_SCOPE_STATIC_INLINE MQ_ELEM_TYPE=int MQ_NAME=int",
+    test,
+    NULL,
+    NULL,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
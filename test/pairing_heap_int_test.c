@@ -0,0 +1,124 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+#define PH_SCOPE HR_SCOPE_STATIC_INLINE
+#define PH_STORAGE HR_STORAGE_DIRECT
+#define PH_ELEM_TYPE int
+#define PH_NAME ph_int
+#define PH_CMP(x, y) ((x) < (y) ? true : false)
+#define PH_POOL_CHUNK 16
+#include "horror/pairing_heap.c"
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    ph_int_t* heap = malloc(sizeof(ph_int_t));
+    ph_int_init(heap);
+    return heap;
+}
+
+
+static void tear_down(void* heap) {
+    ph_int_cleanup(heap);
+    free(heap);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* heap) {
+    ph_int_node_t* nodes[200];
+
+    size_t i;
+    for (i = 0; i < 200; i++) {
+        nodes[i] = ph_int_insert(heap, munit_rand_int_range(0, 1000));
+        munit_assert_not_null(nodes[i]);
+    }
+
+    // Push every other element toward the front.
+    for (i = 0; i < 200; i += 2) {
+        *ph_int_get(nodes[i]) -= munit_rand_int_range(0, 1000);
+        ph_int_decrease_key(heap, nodes[i]);
+    }
+
+    *ph_int_get(nodes[199]) = -5000;
+    ph_int_decrease_key(heap, nodes[199]);
+    munit_assert_int(*ph_int_peek(heap), ==, -5000);
+
+    // Take half the elements out, which reshapes the tree, then meld in a
+    // second heap.
+    int min = INT_MIN;
+    for (i = 0; i < 100; i++) {
+        int x = ph_int_extract(heap);
+        munit_assert_int(min, <=, x);
+        min = x;
+    }
+
+    ph_int_t other;
+    ph_int_init(&other);
+
+    for (i = 0; i < 100; i++) {
+        munit_assert_not_null(ph_int_insert(&other, min + munit_rand_int_range(0, 1000)));
+    }
+
+    ph_int_meld(heap, &other);
+    munit_assert_size(ph_int_size(&other), ==, 0);
+    munit_assert_size(ph_int_size(heap), ==, 200);
+
+    // Nodes from either pool are reused once freed.
+    for (i = 0; i < 50; i++) {
+        munit_assert_not_null(ph_int_insert(heap, min + munit_rand_int_range(0, 1000)));
+    }
+
+    size_t count = 0;
+    while (ph_int_size(heap) > 0) {
+        int x = ph_int_extract(heap);
+        munit_assert_int(min, <=, x);
+        min = x;
+        count++;
+    }
+
+    munit_assert_size(count, ==, 250);
+
+    ph_int_cleanup(&other);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest ph_int_test = {
+    "/pairing_heap PH_SCOPE=HR_SCOPE_STATIC_INLINE PH_ELEM_TYPE=int PH_NAME=int",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
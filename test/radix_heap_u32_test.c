@@ -0,0 +1,120 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+#define RX_SCOPE HR_SCOPE_STATIC_INLINE
+#define RX_STORAGE HR_STORAGE_DIRECT
+#define RX_ELEM_TYPE uint32_t
+#define RX_KEY_TYPE uint32_t
+#define RX_NAME rx_u32
+#define RX_KEY(x) (x)
+#include "horror/radix_heap.c"
+
+
+#define N 300
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    rx_u32_t* heap = malloc(sizeof(rx_u32_t));
+    rx_u32_init(heap);
+    return heap;
+}
+
+
+static void tear_down(void* heap) {
+    rx_u32_cleanup(heap);
+    free(heap);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* heap) {
+    size_t i, used = 0;
+
+    for (i = 0; i < N; i++) {
+        munit_assert_true(rx_u32_insert(heap, (uint32_t)munit_rand_int_range(0, 1 << 20)));
+        used++;
+    }
+
+    // Keep the heap topped up the way a simulation does, never scheduling
+    // anything before the current time. Some keys repeat the current time
+    // exactly, and a few land far out to reach the high buckets.
+    uint32_t now = 0;
+    for (i = 0; i < 4 * N; i++) {
+        uint32_t x = *rx_u32_peek(heap);
+        munit_assert_uint32(rx_u32_extract(heap), ==, x);
+        munit_assert_uint32(now, <=, x);
+        munit_assert_uint32(rx_u32_last_key(heap), <=, x);
+        now = x;
+        used--;
+
+        switch (munit_rand_int_range(0, 3)) {
+        case 0:
+            munit_assert_true(rx_u32_insert(heap, now));
+            used++;
+            break;
+        case 1:
+            munit_assert_true(rx_u32_insert(heap, now + (uint32_t)munit_rand_int_range(0, 1 << 24)));
+            used++;
+            break;
+        default:
+            munit_assert_true(rx_u32_insert(heap, now + (uint32_t)munit_rand_int_range(0, 64)));
+            munit_assert_true(rx_u32_insert(heap, now + (uint32_t)munit_rand_int_range(0, 1024)));
+            used += 2;
+            break;
+        }
+
+        munit_assert_size(rx_u32_size(heap), ==, used);
+    }
+
+    while (rx_u32_size(heap) > 0) {
+        uint32_t x = rx_u32_extract(heap);
+        munit_assert_uint32(now, <=, x);
+        now = x;
+        used--;
+    }
+
+    munit_assert_size(used, ==, 0);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest rx_u32_test = {
+    "/radix_heap RX_SCOPE=HR_SCOPE_STATIC_INLINE RX_ELEM_TYPE=uint32_t RX_NAME=u32",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
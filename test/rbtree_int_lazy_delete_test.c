@@ -0,0 +1,199 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "munit.h"
+
+#include "horror/macro.h"
+#include "horror/rbtree.h"
+
+#define RB_SCOPE HR_SCOPE_STATIC_INLINE
+#define RB_STORAGE HR_STORAGE_DIRECT
+#define RB_ELEM_TYPE int
+#define RB_NAME rb_int
+#define RB_CMP(x, y) ((x) < (y) ? -1 : ((x) > (y) ? 1 : 0))
+#define RB_LAZY_DELETE
+#define RB_DEBUG
+#define RB_DEBUG_DUMP(x) do { fprintf(stderr, "Node: %i.\n", x); } while (0)
+#include "horror/rbtree.c"
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    rb_int_t* tree = malloc(sizeof(rb_int_t));
+    rb_int_init(tree);
+    return tree;
+}
+
+
+static void tear_down(void* tree) {
+    rb_int_cleanup(tree);
+    free(tree);
+}
+
+
+static void assert_traversal(rb_int_t* tree, const bool* present) {
+    rb_int_trav_t trav;
+    rb_int_trav_init(&trav, tree, RB_RIGHT);
+
+    size_t count = 0;
+    int last = -1;
+    int* x;
+    while ((x = rb_int_next(&trav)) != NULL) {
+        munit_assert_int(last, <, *x);
+        munit_assert(present[*x]);
+        last = *x;
+        count++;
+    }
+
+    munit_assert_size(count, ==, rb_int_size(tree));
+}
+
+
+static MunitResult test(const MunitParameter params[], void* tree) {
+    bool present[100] = { false };
+
+    munit_assert_size(rb_int_size(tree), ==, 0);
+
+    size_t i;
+    for (i = 0; i < 100; i++) {
+        int x = munit_rand_int_range(0, 99);
+
+        size_t old_size = rb_int_size(tree);
+
+        fprintf(stderr, "Inserting %i...\n", x);
+        munit_assert(rb_int_insert(tree, x));
+        munit_assert(rb_int_assert(tree));
+
+        if (present[x]) {
+            munit_assert_size(old_size, ==, rb_int_size(tree));
+        } else {
+            munit_assert_size(old_size + 1, ==, rb_int_size(tree));
+        }
+
+        present[x] = true;
+        munit_assert_not_null(rb_int_find(tree, x));
+    }
+
+    for (i = 0; i < 300; i++) {
+        int x = munit_rand_int_range(0, 99);
+
+        size_t old_size = rb_int_size(tree);
+
+        if (munit_rand_int_range(0, 2) == 0) {
+            fprintf(stderr, "Inserting %i...\n", x);
+            munit_assert(rb_int_insert(tree, x));
+            munit_assert_size(old_size + !present[x], ==, rb_int_size(tree));
+            present[x] = true;
+        } else {
+            fprintf(stderr, "Removing %i...\n", x);
+            rb_int_remove(tree, x);
+            munit_assert_size(old_size - present[x], ==, rb_int_size(tree));
+            present[x] = false;
+        }
+
+        munit_assert(rb_int_assert(tree));
+
+        if (present[x]) {
+            munit_assert_not_null(rb_int_find(tree, x));
+            munit_assert_int(*rb_int_find(tree, x), ==, x);
+        } else {
+            munit_assert_null(rb_int_find(tree, x));
+        }
+
+        assert_traversal(tree, present);
+    }
+
+    munit_assert(rb_int_rebuild(tree));
+    munit_assert(rb_int_assert(tree));
+    assert_traversal(tree, present);
+
+    while (rb_int_size(tree) > 0) {
+        int* min = rb_int_min(tree);
+        munit_assert_not_null(min);
+        munit_assert(present[*min]);
+        present[*min] = false;
+        munit_assert_int(*min, ==, rb_int_pop_min(tree));
+        munit_assert(rb_int_assert(tree));
+    }
+
+    munit_assert_null(rb_int_min(tree));
+
+    while (rb_int_size(tree) < 50) {
+        int x = munit_rand_int_range(0, 99);
+        rb_int_insert(tree, x);
+    }
+
+    while (rb_int_size(tree) > 0) {
+        int* max = rb_int_max(tree);
+        munit_assert_not_null(max);
+        munit_assert_int(*max, ==, rb_int_pop_max(tree));
+        munit_assert(rb_int_assert(tree));
+    }
+
+    // Popping from either end steps over the tombstones which pile up there.
+    for (i = 0; i < 100; i++) {
+        munit_assert(rb_int_insert(tree, (int)i));
+        present[i] = true;
+    }
+    for (i = 0; i < 100; i += 3) {
+        rb_int_remove(tree, (int)i);
+        present[i] = false;
+    }
+    munit_assert(rb_int_assert(tree));
+
+    int lo = 0, hi = 99;
+    while (rb_int_size(tree) > 0) {
+        while (!present[lo]) lo++;
+        while (!present[hi]) hi--;
+
+        if (munit_rand_int_range(0, 1) == 0) {
+            munit_assert_int(*rb_int_min(tree), ==, lo);
+            munit_assert_int(rb_int_pop_min(tree), ==, lo);
+            present[lo] = false;
+        } else {
+            munit_assert_int(*rb_int_max(tree), ==, hi);
+            munit_assert_int(rb_int_pop_max(tree), ==, hi);
+            present[hi] = false;
+        }
+
+        int x = munit_rand_int_range(0, 99);
+        rb_int_remove(tree, x);
+        present[x] = false;
+
+        munit_assert(rb_int_assert(tree));
+        assert_traversal(tree, present);
+    }
+
+    return MUNIT_OK;
+}
+
+
+MunitTest rb_int_lazy_delete_test = {
+    "/rbtree RB_SCOPE=HR_SCOPE_STATIC_INLINE RB_ELEM_TYPE=int RB_NAME=int RB_LAZY_DELETE",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
@@ -0,0 +1,157 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+#include "horror/rbtree.h"
+
+#define RB_SCOPE HR_SCOPE_STATIC_INLINE
+#define RB_STORAGE HR_STORAGE_DIRECT
+#define RB_ELEM_TYPE int
+#define RB_NAME rb_int
+#define RB_CMP(x, y) ((x) < (y) ? -1 : ((x) > (y) ? 1 : 0))
+#define RB_MMAP
+#include "horror/rbtree.c"
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    rb_int_t* tree = malloc(sizeof(rb_int_t));
+    rb_int_init(tree);
+    return tree;
+}
+
+
+static void tear_down(void* tree) {
+    rb_int_cleanup(tree);
+    free(tree);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* tree) {
+    char path[] = "/tmp/horror-rbtree-XXXXXX";
+
+    size_t i;
+    for (i = 0; i < 1000; i++) {
+        rb_int_insert(tree, munit_rand_int_range(0, 2000));
+    }
+
+    int fd = mkstemp(path);
+    munit_assert_int(fd, >=, 0);
+    munit_assert(rb_int_save(tree, fd));
+
+    // Images whose links don't make a breadth-first tree are turned away:
+    // a link past the end, one back up the tree, and a node left dangling.
+    rb_int_map_t map;
+    off_t records = sizeof(rb_image_header_t);
+    uint32_t links[2], bad;
+    munit_assert_int(pread(fd, links, sizeof(links), records), ==, sizeof(links));
+
+    bad = (uint32_t)rb_int_size(tree) + 5;
+    munit_assert_int(pwrite(fd, &bad, sizeof(bad), records), ==, sizeof(bad));
+    munit_assert_false(rb_int_map(&map, path));
+    bad = 0;
+    munit_assert_int(pwrite(fd, &bad, sizeof(bad), records), ==, sizeof(bad));
+    munit_assert_false(rb_int_map(&map, path));
+    bad = RB_IMAGE_NIL;
+    munit_assert_int(pwrite(fd, &bad, sizeof(bad), records), ==, sizeof(bad));
+    munit_assert_false(rb_int_map(&map, path));
+
+    munit_assert_int(pwrite(fd, links, sizeof(links), records), ==, sizeof(links));
+    close(fd);
+
+    munit_assert(rb_int_map(&map, path));
+    unlink(path);
+
+    munit_assert_size(rb_int_map_size(&map), ==, rb_int_size(tree));
+
+    for (int x = -10; x < 2010; x++) {
+        const int* expected = rb_int_find(tree, x);
+        const int* found = rb_int_map_find(&map, x);
+
+        if (expected == NULL) {
+            munit_assert_null(found);
+        } else {
+            munit_assert_not_null(found);
+            munit_assert_int(*found, ==, x);
+        }
+    }
+
+    for (int dec = RB_LEFT; dec <= RB_RIGHT; dec++) {
+        rb_int_trav_t trav;
+        rb_int_map_trav_t map_trav;
+        rb_int_trav_init(&trav, tree, dec);
+        rb_int_map_trav_init(&map_trav, &map, dec);
+
+        int* expected;
+        while ((expected = rb_int_next(&trav)) != NULL) {
+            const int* found = rb_int_map_next(&map_trav);
+            munit_assert_not_null(found);
+            munit_assert_int(*found, ==, *expected);
+        }
+
+        munit_assert_null(rb_int_map_next(&map_trav));
+    }
+
+    rb_int_unmap(&map);
+
+    // Empty trees make empty images.
+    rb_int_t empty;
+    rb_int_init(&empty);
+
+    char empty_path[] = "/tmp/horror-rbtree-XXXXXX";
+    fd = mkstemp(empty_path);
+    munit_assert_int(fd, >=, 0);
+    munit_assert(rb_int_save(&empty, fd));
+    close(fd);
+
+    munit_assert(rb_int_map(&map, empty_path));
+    unlink(empty_path);
+
+    munit_assert_size(rb_int_map_size(&map), ==, 0);
+    munit_assert_null(rb_int_map_find(&map, 0));
+
+    rb_int_map_trav_t map_trav;
+    rb_int_map_trav_init(&map_trav, &map, RB_RIGHT);
+    munit_assert_null(rb_int_map_next(&map_trav));
+
+    rb_int_unmap(&map);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest rb_int_mmap_test = {
+    "/rbtree RB_SCOPE=HR_SCOPE_STATIC_INLINE RB_ELEM_TYPE=int RB_NAME=int RB_MMAP",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
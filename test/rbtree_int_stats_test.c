@@ -0,0 +1,113 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "munit.h"
+
+#include "horror/macro.h"
+#include "horror/rbtree.h"
+
+#define RB_SCOPE HR_SCOPE_STATIC_INLINE
+#define RB_STORAGE HR_STORAGE_DIRECT
+#define RB_ELEM_TYPE int
+#define RB_NAME rb_int
+#define RB_CMP(x, y) ((x) < (y) ? -1 : ((x) > (y) ? 1 : 0))
+#define RB_STATS
+#define RB_DEBUG
+#include "horror/rbtree.c"
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    rb_int_t* tree = malloc(sizeof(rb_int_t));
+    rb_int_init(tree);
+    return tree;
+}
+
+
+static void tear_down(void* tree) {
+    rb_int_cleanup(tree);
+    free(tree);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* tree) {
+    rb_stats_t stats = rb_int_stats(tree);
+    munit_assert_uint64(stats.comparisons, ==, 0);
+    munit_assert_uint64(stats.nodes_allocated, ==, 0);
+
+    // Ascending inserts are the worst case for rotations.
+    int i;
+    for (i = 0; i < 1000; i++) {
+        munit_assert(rb_int_insert(tree, i));
+    }
+
+    munit_assert(rb_int_assert(tree));
+
+    stats = rb_int_stats(tree);
+    munit_assert_uint64(stats.nodes_allocated, ==, 1000);
+    munit_assert_uint64(stats.nodes_freed, ==, 0);
+    munit_assert_uint64(stats.single_rotations, >, 0);
+    munit_assert_uint64(stats.color_flips, >, 0);
+    munit_assert_uint64(stats.comparisons, >=, 999);
+    munit_assert_size(stats.max_depth, >, 0);
+    // A red-black tree of 1000 nodes is never deeper than 2 log2(1001).
+    munit_assert_size(stats.max_depth, <=, 20);
+
+    rb_int_stats_reset(tree);
+
+    munit_assert_not_null(rb_int_find(tree, 500));
+
+    stats = rb_int_stats(tree);
+    munit_assert_uint64(stats.comparisons, ==, stats.max_depth + 1);
+    munit_assert_uint64(stats.single_rotations, ==, 0);
+    munit_assert_uint64(stats.double_rotations, ==, 0);
+
+    rb_int_stats_reset(tree);
+
+    for (i = 0; i < 1000; i += 2) {
+        rb_int_remove(tree, i);
+    }
+
+    munit_assert(rb_int_assert(tree));
+
+    while (rb_int_size(tree) > 0) {
+        rb_int_pop_min(tree);
+    }
+
+    stats = rb_int_stats(tree);
+    munit_assert_uint64(stats.nodes_allocated, ==, 0);
+    munit_assert_uint64(stats.nodes_freed, ==, 1000);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest rb_int_stats_test = {
+    "/rbtree RB_SCOPE=HR_SCOPE_STATIC_INLINE RB_ELEM_TYPE=int RB_NAME=int RB_STATS",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
@@ -0,0 +1,125 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "munit.h"
+
+#include "horror/macro.h"
+#include "horror/rbtree.h"
+
+#define RB_SCOPE HR_SCOPE_STATIC_INLINE
+#define RB_STORAGE HR_STORAGE_DIRECT
+#define RB_ELEM_TYPE int
+#define RB_NAME rb_int
+#define RB_CMP(x, y) ((x) < (y) ? -1 : ((x) > (y) ? 1 : 0))
+#include "horror/rbtree.c"
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    rb_int_t* tree = malloc(sizeof(rb_int_t));
+    rb_int_init(tree);
+    return tree;
+}
+
+
+static void tear_down(void* tree) {
+    rb_int_cleanup(tree);
+    free(tree);
+}
+
+
+static void assert_split(rb_int_t* tree, size_t k) {
+    rb_int_trav_t whole;
+    rb_int_trav_t* travs = malloc(k * sizeof(rb_int_trav_t));
+
+    munit_assert(rb_int_trav_split(tree, k, travs));
+    rb_int_trav_init(&whole, tree, RB_RIGHT);
+
+    // Reading the cursors one after another must give back the whole tree,
+    // in order, exactly once.
+    size_t largest = 0;
+    for (size_t j = 0; j < k; j++) {
+        size_t count = 0;
+        int* x;
+        while ((x = rb_int_next(&travs[j])) != NULL) {
+            int* expected = rb_int_next(&whole);
+            munit_assert_not_null(expected);
+            munit_assert_int(*x, ==, *expected);
+            count++;
+        }
+
+        if (count > largest) {
+            largest = count;
+        }
+    }
+
+    munit_assert_null(rb_int_next(&whole));
+
+    // The slices are cut by position among the top nodes rather than by
+    // count, so they won't be exactly even, but none of them should be far
+    // off its fair share.
+    if (k > 1 && rb_int_size(tree) >= 1000) {
+        munit_assert_size(largest, <=, 4 * rb_int_size(tree) / k);
+    }
+
+    free(travs);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* tree) {
+    const size_t ks[] = { 1, 2, 3, 4, 7, 16, 64 };
+    const size_t nks = sizeof(ks) / sizeof(ks[0]);
+
+    for (size_t i = 0; i < nks; i++) {
+        assert_split(tree, ks[i]);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        rb_int_insert(tree, i);
+    }
+
+    for (size_t i = 0; i < nks; i++) {
+        assert_split(tree, ks[i]);
+    }
+
+    while (rb_int_size(tree) < 10000) {
+        rb_int_insert(tree, munit_rand_int_range(0, 1000000));
+    }
+
+    for (size_t i = 0; i < nks; i++) {
+        assert_split(tree, ks[i]);
+    }
+
+    return MUNIT_OK;
+}
+
+
+MunitTest rb_int_trav_split_test = {
+    "/rbtree RB_SCOPE=HR_SCOPE_STATIC_INLINE RB_ELEM_TYPE=int RB_NAME=int trav_split",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
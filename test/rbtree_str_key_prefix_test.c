@@ -0,0 +1,175 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+#include "munit.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "horror/macro.h"
+#include "horror/rbtree.h"
+
+typedef struct {
+    char key[24];
+} str_key_t;
+
+
+// The first eight bytes of the key, big-endian, so that integer order agrees
+// with strcmp order. Keys are zero-padded, so short keys need no special case.
+static inline uint64_t str_key_prefix(const str_key_t* x) {
+    uint64_t prefix = 0;
+    int i;
+    for (i = 0; i < 8; i++) {
+        prefix = (prefix << 8) | (unsigned char)x->key[i];
+    }
+    return prefix;
+}
+
+
+#define RB_SCOPE HR_SCOPE_STATIC_INLINE
+#define RB_STORAGE HR_STORAGE_OWNED_INDIRECT
+#define RB_ELEM_TYPE str_key_t
+#define RB_NAME rb_str
+#define RB_CMP(x, y) (strcmp((x)->key, (y)->key))
+#define RB_KEY_PREFIX_TYPE uint64_t
+#define RB_KEY_PREFIX(x) (str_key_prefix(x))
+#define RB_STATS
+#define RB_DEBUG
+#include "horror/rbtree.c"
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    rb_str_t* tree = malloc(sizeof(rb_str_t));
+    rb_str_init(tree);
+    return tree;
+}
+
+
+static void tear_down(void* tree) {
+    rb_str_cleanup(tree);
+    free(tree);
+}
+
+
+static str_key_t make_key(const char* fmt, int i) {
+    str_key_t k;
+    memset(&k, 0, sizeof(k));
+    snprintf(k.key, sizeof(k.key), fmt, i);
+    return k;
+}
+
+
+static MunitResult test(const MunitParameter params[], void* tree) {
+    int i;
+
+    // Short keys fit entirely within the prefix, so every comparison short of
+    // an exact match is settled without dereferencing the element.
+    for (i = 0; i < 500; i++) {
+        str_key_t k = make_key("%06d", (i * 7919) % 500);
+        munit_assert(rb_str_insert(tree, &k));
+    }
+
+    munit_assert(rb_str_assert(tree));
+    munit_assert_size(rb_str_size(tree), ==, 500);
+
+    rb_str_stats_reset(tree);
+
+    for (i = 0; i < 500; i++) {
+        str_key_t k = make_key("%06d", i);
+        str_key_t* found = rb_str_find(tree, &k);
+        munit_assert_not_null(found);
+        munit_assert_string_equal(found->key, k.key);
+    }
+
+    munit_assert_uint64(rb_str_stats(tree).comparisons, ==, 500);
+
+    str_key_t missing = make_key("%06d", 500);
+    munit_assert_null(rb_str_find(tree, &missing));
+
+    // Long keys sharing their first eight bytes tie on the prefix and fall
+    // back to the full comparison.
+    for (i = 0; i < 500; i++) {
+        str_key_t k = make_key("shared-prefix-%04d", (i * 7919) % 500);
+        munit_assert(rb_str_insert(tree, &k));
+    }
+
+    munit_assert(rb_str_assert(tree));
+    munit_assert_size(rb_str_size(tree), ==, 1000);
+
+    for (i = 0; i < 500; i++) {
+        str_key_t k = make_key("shared-prefix-%04d", i);
+        str_key_t* found = rb_str_find(tree, &k);
+        munit_assert_not_null(found);
+        munit_assert_string_equal(found->key, k.key);
+    }
+
+    // Removals move elements between nodes; their prefixes must follow.
+    for (i = 0; i < 500; i += 2) {
+        str_key_t k = make_key("%06d", i);
+        rb_str_remove(tree, &k);
+        k = make_key("shared-prefix-%04d", i);
+        rb_str_remove(tree, &k);
+    }
+
+    munit_assert(rb_str_assert(tree));
+    munit_assert_size(rb_str_size(tree), ==, 500);
+
+    rb_str_trav_t trav;
+    rb_str_trav_init(&trav, tree, RB_RIGHT);
+
+    str_key_t* prev = NULL;
+    str_key_t* cur;
+    size_t count = 0;
+    while ((cur = rb_str_next(&trav)) != NULL) {
+        if (prev != NULL) {
+            munit_assert_int(strcmp(prev->key, cur->key), <, 0);
+        }
+        prev = cur;
+        count++;
+    }
+
+    munit_assert_size(count, ==, 500);
+
+    str_key_t popped;
+    rb_str_pop_min(tree, &popped);
+    munit_assert_string_equal(popped.key, "000001");
+    rb_str_pop_max(tree, &popped);
+    munit_assert_string_equal(popped.key, "shared-prefix-0499");
+
+    munit_assert(rb_str_assert(tree));
+
+    return MUNIT_OK;
+}
+
+
+MunitTest rb_str_key_prefix_test = {
+    "/rbtree RB_SCOPE=HR_SCOPE_STATIC_INLINE RB_ELEM_TYPE=str_key_t RB_NAME=str RB_STORAGE=HR_STORAGE_OWNED_INDIRECT RB_KEY_PREFIX",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
@@ -29,10 +29,38 @@ SOFTWARE.
 #include "rbtree_int_test.h"
 #include "rbtree_int_owned_indirect_test.h"
 #include "rbtree_int_borrowed_indirect_test.h"
+#include "rbtree_int_lazy_delete_test.h"
+#include "rbtree_int_mmap_test.h"
+#include "rbtree_int_stats_test.h"
+#include "rbtree_int_trav_split_test.h"
+#include "rbtree_str_key_prefix_test.h"
 
 #include "heap_int_test.h"
 #include "heap_int_owned_indirect_test.h"
+#include "heap_int_pool_test.h"
 #include "heap_int_borrowed_indirect_test.h"
+#include "heap_int_arity_test.h"
+#include "heap_int_build_test.h"
+#include "heap_int_indexed_test.h"
+#include "heap_int_bounded_test.h"
+#include "heap_int_replace_test.h"
+#include "heap_int_insert_buffer_test.h"
+#include "heap_int_extract_until_test.h"
+#include "heap_int_shrink_test.h"
+#include "heap_int_sort_test.h"
+#include "heap_int_bottom_up_test.h"
+#include "heap_job_key_test.h"
+#include "heap_int_simd_test.h"
+
+#include "pairing_heap_int_test.h"
+#include "minmax_heap_int_test.h"
+#include "radix_heap_u32_test.h"
+#include "timer_wheel_int_test.h"
+#include "timer_wheel_u32_test.h"
+#include "multiqueue_int_test.h"
+#include "external_heap_int_test.h"
+#include "kway_merge_int_test.h"
+#include "kway_merge_int_loser_tree_test.h"
 
 #include "dynarray_int_test.h"
 #include "dynarray_int_owned_indirect_test.h"
@@ -43,9 +71,36 @@ int main (int argc, char* argv[]) {
         rb_int_test,
         rb_int_owned_indirect_test,
         rb_int_borrowed_indirect_test,
+        rb_int_lazy_delete_test,
+        rb_int_mmap_test,
+        rb_int_stats_test,
+        rb_int_trav_split_test,
+        rb_str_key_prefix_test,
         hp_int_test,
         hp_int_owned_indirect_test,
+        hp_int_pool_test,
         hp_int_borrowed_indirect_test,
+        hp_int_arity_test,
+        hp_int_build_test,
+        hp_int_indexed_test,
+        hp_int_bounded_test,
+        hp_int_replace_test,
+        hp_int_insert_buffer_test,
+        hp_int_extract_until_test,
+        hp_int_shrink_test,
+        hp_int_sort_test,
+        hp_int_bottom_up_test,
+        hp_job_key_test,
+        hp_int_simd_test,
+        ph_int_test,
+        mm_int_test,
+        rx_u32_test,
+        tw_int_test,
+        tw_u32_test,
+        mq_int_test,
+        eh_int_test,
+        km_int_test,
+        km_int_loser_tree_test,
         da_int_test,
         da_int_owned_indirect_test,
         da_int_borrowed_indirect_test,
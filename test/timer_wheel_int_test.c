@@ -0,0 +1,150 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+// A tiny wheel, 3 levels of 8 slots, so that deadlines regularly overflow
+// into the far heap.
+#define TW_SCOPE HR_SCOPE_STATIC_INLINE
+#define TW_STORAGE HR_STORAGE_DIRECT
+#define TW_ELEM_TYPE int
+#define TW_NAME tw_int
+#define TW_LEVEL_BITS 3
+#define TW_LEVELS 3
+#define TW_POOL_CHUNK 16
+#include "horror/timer_wheel.c"
+
+
+#define N 200
+#define BATCH 7
+
+enum { IDLE, ARMED, FIRED, CANCELLED };
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    tw_int_t* wheel = malloc(sizeof(tw_int_t));
+    tw_int_init(wheel, 100);
+    return wheel;
+}
+
+
+static void tear_down(void* wheel) {
+    tw_int_cleanup(wheel);
+    free(wheel);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* wheel) {
+    tw_int_timer_t* timers[N];
+    uint64_t deadlines[N];
+    int states[N] = { IDLE };
+    uint64_t now = 100;
+    size_t armed = 0, i;
+
+    for (i = 0; i < 4000; i++) {
+        int id = munit_rand_int_range(0, N - 1);
+
+        switch (munit_rand_int_range(0, 4)) {
+        case 0:
+        case 1:
+            // Mostly near deadlines, some far beyond the wheel's 512 ticks,
+            // and some already past.
+            if (states[id] == ARMED) break;
+            switch (munit_rand_int_range(0, 9)) {
+            case 0: deadlines[id] = now + munit_rand_int_range(0, 100000); break;
+            case 1: deadlines[id] = now - munit_rand_int_range(0, 50); break;
+            default: deadlines[id] = now + munit_rand_int_range(0, 600); break;
+            }
+            timers[id] = tw_int_arm(wheel, deadlines[id], id);
+            munit_assert_not_null(timers[id]);
+            munit_assert_int(*tw_int_get(timers[id]), ==, id);
+            states[id] = ARMED;
+            armed++;
+            break;
+        case 2:
+            if (states[id] != ARMED) break;
+            tw_int_cancel(wheel, timers[id]);
+            states[id] = CANCELLED;
+            armed--;
+            break;
+        case 3:
+            if (states[id] != ARMED) break;
+            deadlines[id] = now + munit_rand_int_range(0, 50000);
+            munit_assert_true(tw_int_rearm(wheel, timers[id], deadlines[id]));
+            munit_assert_uint64(tw_int_deadline(timers[id]), ==, deadlines[id]);
+            break;
+        case 4: {
+            // Usually a few ticks at a time, now and then a long jump.
+            now += munit_rand_int_range(0, 9) == 0
+                ? munit_rand_int_range(0, 70000)
+                : munit_rand_int_range(0, 40);
+
+            int fired[BATCH];
+            size_t n, j;
+            do {
+                n = tw_int_advance(wheel, now, fired, BATCH);
+                for (j = 0; j < n; j++) {
+                    munit_assert_int(states[fired[j]], ==, ARMED);
+                    munit_assert_uint64(deadlines[fired[j]], <=, now);
+                    states[fired[j]] = FIRED;
+                    armed--;
+                }
+            } while (n == BATCH);
+
+            munit_assert_uint64(tw_int_now(wheel), ==, now);
+
+            // Nothing due may be left behind.
+            for (j = 0; j < N; j++) {
+                if (states[j] == ARMED) {
+                    munit_assert_uint64(deadlines[j], >, now);
+                }
+            }
+            break;
+        }
+        }
+
+        munit_assert_size(tw_int_size(wheel), ==, armed);
+    }
+
+    return MUNIT_OK;
+}
+
+
+MunitTest tw_int_test = {
+    "/timer_wheel TW_SCOPE=HR_SCOPE_STATIC_INLINE TW_ELEM_TYPE=int TW_NAME=int",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};
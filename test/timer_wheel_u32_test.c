@@ -0,0 +1,139 @@
+/*
+
+The Horror generic C data structure library. Abuse at your own risk.
+
+Copyright (c) 2016 Sean Leffler
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "munit.h"
+
+#include "horror/macro.h"
+
+// 32-bit ticks with the default 4 levels of 256 slots, so the wheel spans
+// every bit of the time type and the far heap is never used.
+#define TW_SCOPE HR_SCOPE_STATIC_INLINE
+#define TW_STORAGE HR_STORAGE_DIRECT
+#define TW_ELEM_TYPE int
+#define TW_NAME tw_u32
+#define TW_TIME_TYPE uint32_t
+#include "horror/timer_wheel.c"
+
+
+#define N 200
+#define BATCH 7
+
+enum { IDLE, ARMED, FIRED };
+
+
+static void* setup(const MunitParameter params[], void* _) {
+    tw_u32_t* wheel = malloc(sizeof(tw_u32_t));
+    munit_assert_true(tw_u32_init(wheel, 0));
+    return wheel;
+}
+
+
+static void tear_down(void* wheel) {
+    tw_u32_cleanup(wheel);
+    free(wheel);
+}
+
+
+static MunitResult test(const MunitParameter params[], void* wheel) {
+    uint32_t deadlines[N];
+    int states[N] = { IDLE };
+    uint32_t now = 0;
+    size_t armed = 0, i, j;
+
+    // A deadline on the top level, whose slots cover the highest 8 bits.
+    int fired[BATCH];
+    munit_assert_not_null(tw_u32_arm(wheel, 100u << 24, -1));
+    munit_assert_size(tw_u32_advance(wheel, (100u << 24) - 1, fired, BATCH), ==, 0);
+    munit_assert_size(tw_u32_advance(wheel, (100u << 24) + 1, fired, BATCH), ==, 1);
+    munit_assert_int(fired[0], ==, -1);
+    now = (100u << 24) + 1;
+
+    // Deadlines at every level, up to the very top of the time type.
+    for (i = 0; i < 3000; i++) {
+        int id = munit_rand_int_range(0, N - 1);
+        uint32_t room = UINT32_MAX - now;
+
+        if (munit_rand_int_range(0, 1) == 0) {
+            if (states[id] == ARMED) continue;
+            uint32_t ahead = (uint32_t)munit_rand_uint32() >> munit_rand_int_range(0, 31);
+            deadlines[id] = now + (ahead < room ? ahead : room);
+            munit_assert_not_null(tw_u32_arm(wheel, deadlines[id], id));
+            states[id] = ARMED;
+            armed++;
+        } else {
+            uint32_t step = (uint32_t)munit_rand_uint32() >> munit_rand_int_range(8, 31);
+            now += step < room / 64 ? step : room / 64;
+
+            size_t n;
+            do {
+                n = tw_u32_advance(wheel, now, fired, BATCH);
+                for (j = 0; j < n; j++) {
+                    munit_assert_int(states[fired[j]], ==, ARMED);
+                    munit_assert_uint32(deadlines[fired[j]], <=, now);
+                    states[fired[j]] = FIRED;
+                    armed--;
+                }
+            } while (n == BATCH);
+
+            munit_assert_uint32(tw_u32_now(wheel), ==, now);
+
+            for (j = 0; j < N; j++) {
+                if (states[j] == ARMED) {
+                    munit_assert_uint32(deadlines[j], >, now);
+                }
+            }
+        }
+
+        munit_assert_size(tw_u32_size(wheel), ==, armed);
+    }
+
+    // Running the clock out to the last tick fires everything.
+    now = UINT32_MAX;
+    size_t n;
+    do {
+        n = tw_u32_advance(wheel, now, fired, BATCH);
+        armed -= n;
+    } while (n == BATCH);
+    munit_assert_size(armed, ==, 0);
+    munit_assert_size(tw_u32_size(wheel), ==, 0);
+
+    return MUNIT_OK;
+}
+
+
+MunitTest tw_u32_test = {
+    "/timer_wheel TW_SCOPE=HR_SCOPE_STATIC_INLINE TW_ELEM_TYPE=int TW_NAME=u32 TW_TIME_TYPE=uint32_t",
+    test,
+    setup,
+    tear_down,
+    MUNIT_TEST_OPTION_NONE,
+    NULL,
+};